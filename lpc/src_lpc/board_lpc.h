@@ -23,17 +23,27 @@
 #define LEDS_LIST { LED_1, LED_2, LED_3, LED_4 }
 
 //botones
+#if defined(DRV_BOTONES_SONDEO)
+// Por sondeo los botones no necesitan linea EINT: cualquier pin de P0 vale
+#define BUTTONS_NUMBER 4
+#else
 #define BUTTONS_NUMBER 3
+#endif
 
 #define BUTTON_1       (INT_EXT1)
 #define BUTTON_2       (INT_EXT2)
 #define BUTTON_3       (INT_EXT3)
+#define BUTTON_4       (BOTON4_GPIO)
 
 #define BUTTON_PULL    1 //poner pullup interno a los botones
 
 #define BUTTONS_ACTIVE_STATE 1
 
+#if defined(DRV_BOTONES_SONDEO)
+#define BUTTONS_LIST { BUTTON_1, BUTTON_2, BUTTON_3, BUTTON_4 }
+#else
 #define BUTTONS_LIST { BUTTON_1, BUTTON_2, BUTTON_3 }
+#endif
 
 //MONITOR
 #define MONITOR_NUMBER 4
@@ -46,4 +56,12 @@
 #define MONITOR_ACTIVE_STATE 1
 
 #define MONITOR_LIST {MONITOR1, MONITOR2, MONITOR3, MONITOR4}
+
+//FLASH: region reservada para svc_almacen (fuera de IROM en el proyecto Keil)
+#define FLASH_ALMACEN_DIR      0x1A000  // sectores 13 y 14 de 8 KB (el 15 es el boot loader)
+#define FLASH_ALMACEN_PAGINAS  2
+
+//TIEMPO
+#define CPU_CLOCK_MHZ      60   // CCLK: PLL x5 sobre el cristal de 12 MHz
+#define TIMER_TICKS_PER_US 15   // PCLK = CCLK/4, reloj de T0/T1
 #endif
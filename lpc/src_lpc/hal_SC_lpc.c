@@ -0,0 +1,21 @@
+/* *****************************************************************************
+ * HAL de secciones críticas para LPC2105 (ARM7TDMI): sin prioridades
+ * enmascarables, se deshabilitan todas las IRQ con el bit I del CPSR.
+ * ****************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "hal_SC.h"
+
+/* El VIC no tiene techo de prioridad: nada que configurar */
+void hal_SC_iniciar(void) {
+}
+
+uint32_t hal_SC_entrar(void) {
+    // En ARM7 el intrínseco devuelve el bit I que había antes (distinto de 0 = ya estaban deshabilitadas)
+    return (uint32_t)__disable_irq();
+}
+
+void hal_SC_salir(uint32_t estado) {
+    if (estado == 0) __enable_irq();
+}
@@ -1,4 +1,5 @@
 #include "hal_consumo.h"
+#include "hal_tiempo.h"
  
 #include <LPC21xx.H>
 
@@ -23,11 +24,40 @@ void hal_consumo_esperar(void){
 }
 
 /**
- * Modo "dormir": igual que esperar en esta versin (WFI).
- * En versiones futuras podra aadir medidas ms agresivas.
+ * Solo Idle: Power-down para T0 y T1 (base de tiempo y canales) y no hay reloj
+ * que apagar aparte ni RAM por secciones. drv_consumo_reposar se queda siempre en
+ * HAL_CONSUMO_ESPERAR: en DEBUG solo se llena la residencia del nivel 0.
  */
-void hal_consumo_dormir(void){
+void hal_consumo_coste(hal_consumo_nivel_t nivel, hal_consumo_coste_t *coste){
+	coste->disponible = (nivel == HAL_CONSUMO_ESPERAR);
+	coste->equilibrio_us = 0;
+	coste->latencia_us = 0;
+}
+
+void hal_consumo_esperar_profundo(void){
+	hal_consumo_esperar();
+}
+
+/**
+ * Modo "dormir": Power-down. El oscilador se para pero RAM y registros se
+ * conservan; un EINT despierta y su ISR se atiende antes de seguir aqu.
+ * El PLL se desengancha al dormir: hasta switch_to_PLL se corre a 12 MHz.
+ */
+uint32_t hal_consumo_dormir(void){
 	EXTWAKE = 0x0F;
 	PCON |= 0X02;
 	switch_to_PLL();
+	return hal_tiempo_ciclos();
+}
+
+/**
+ * Causa del arranque: el LPC2105 no tiene registro de causa de reset; solo el
+ * flag de timeout del watchdog (WDTOF) sobrevive al reset que provoca.
+ */
+uint32_t hal_consumo_causa_arranque(void){
+	if (WDMOD & 0x04) {
+		WDMOD &= ~0x04;
+		return HAL_CONSUMO_ARRANQUE_PERRO;
+	}
+	return HAL_CONSUMO_ARRANQUE_ENCENDIDO;
 }
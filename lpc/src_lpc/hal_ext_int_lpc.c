@@ -245,4 +245,16 @@ void hal_ext_int_limpiar_pendiente(uint32_t id_linea)
     }
 }
 
+//Sin captura hardware: los EINT no pueden disparar las capturas de los timers
+bool hal_ext_int_marca_flanco(uint32_t id_linea, uint64_t *tick)
+{
+    (void)id_linea;
+    (void)tick;
+    return false;
+}
 
+//Sin apagado en frío: Power-down conserva el estado y el EINT entra por su ISR
+uint32_t hal_ext_int_despertar(void)
+{
+    return 0;
+}
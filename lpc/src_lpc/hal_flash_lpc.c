@@ -0,0 +1,81 @@
+/* *****************************************************************************
+ * P.H.2025: HAL de flash para LPC2105 (IAP de la ROM de arranque)
+ *
+ * Sectores uniformes de 8 KB (el último lo ocupa el boot loader). El IAP programa
+ * bloques de 256 B alineados y copiados desde RAM: una escritura parcial se monta
+ * en un bloque relleno de 0xFF, que deja intactos los bytes que no toca.
+ * Durante el IAP la flash no es accesible (tampoco los vectores): IRQ deshabilitadas.
+ * El IAP usa los 32 bytes más altos de la RAM: no deben contener datos de la aplicación.
+ * El proyecto de Keil los deja fuera (IRAM1 y RW_IRAM1 de 0x7FE0 bytes, no 0x8000).
+ */
+#include "hal_flash.h"
+#include "hal_SC.h"
+#include "board.h"
+#include <LPC210x.H>
+
+#define FLASH_PAGINA_BYTES  8192u
+#define IAP_BLOQUE_BYTES    256u
+#define IAP_DIRECCION       0x7FFFFFF1u
+#define IAP_CCLK_KHZ        (CPU_CLOCK_MHZ * 1000u)
+
+// Comandos y código de retorno del IAP (manual de usuario LPC2104/5/6)
+#define IAP_PREPARAR        50u
+#define IAP_COPIAR_RAM      51u
+#define IAP_BORRAR          52u
+#define IAP_CMD_SUCCESS     0u
+
+typedef void (*iap_t)(uint32_t comando[], uint32_t resultado[]);
+static const iap_t iap = (iap_t)IAP_DIRECCION;
+
+static uint32_t s_bloque[IAP_BLOQUE_BYTES / 4];
+
+static bool iap_llamar(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint32_t c4) {
+    uint32_t comando[5] = { c0, c1, c2, c3, c4 };
+    uint32_t resultado[3];
+
+    // Restaura el estado previo: no rehabilita las IRQ si ya venía de una sección crítica
+    uint32_t estado = hal_SC_entrar();
+    iap(comando, resultado);
+    hal_SC_salir(estado);
+    return resultado[0] == IAP_CMD_SUCCESS;
+}
+
+static bool iap_preparar(uint32_t sector) {
+    return iap_llamar(IAP_PREPARAR, sector, sector, 0, 0);
+}
+
+uint32_t hal_flash_tam_pagina(void) {
+    return FLASH_PAGINA_BYTES;
+}
+
+bool hal_flash_borrar_pagina(uint32_t dir) {
+    if (dir % FLASH_PAGINA_BYTES) return false;
+
+    uint32_t sector = dir / FLASH_PAGINA_BYTES;
+    if (!iap_preparar(sector)) return false;
+    return iap_llamar(IAP_BORRAR, sector, sector, IAP_CCLK_KHZ, 0);
+}
+
+bool hal_flash_escribir(uint32_t dir, const uint32_t *datos, uint32_t num) {
+    if (dir & 3u) return false;
+
+    while (num > 0) {
+        uint32_t base = dir & ~(IAP_BLOQUE_BYTES - 1u);
+        uint32_t primera = (dir - base) / 4;
+        uint32_t cuantas = IAP_BLOQUE_BYTES / 4 - primera;
+        if (cuantas > num) cuantas = num;
+
+        for (uint32_t i = 0; i < IAP_BLOQUE_BYTES / 4; i++) s_bloque[i] = 0xFFFFFFFFu;
+        for (uint32_t i = 0; i < cuantas; i++) s_bloque[primera + i] = datos[i];
+
+        if (!iap_preparar(base / FLASH_PAGINA_BYTES)) return false;
+        if (!iap_llamar(IAP_COPIAR_RAM, base, (uint32_t)s_bloque, IAP_BLOQUE_BYTES, IAP_CCLK_KHZ)) {
+            return false;
+        }
+
+        dir += cuantas * 4;
+        datos += cuantas;
+        num -= cuantas;
+    }
+    return true;
+}
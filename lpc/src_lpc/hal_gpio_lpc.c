@@ -46,6 +46,26 @@ uint32_t hal_gpio_leer(HAL_GPIO_PIN_T gpio){
 }
 
 
+/**
+ * Entrada GPIO (funcion 00 en PINSEL). El LPC2105 no tiene pull-ups
+ * configurables: los pone la placa, pullup se ignora
+ */
+void hal_gpio_entrada(HAL_GPIO_PIN_T gpio, uint32_t pullup){
+	(void)pullup;
+	if (gpio < 16) PINSEL0 &= ~(3UL << (2 * gpio));
+	else PINSEL1 &= ~(3UL << (2 * (gpio - 16)));
+	IODIR = IODIR & ~(1UL << gpio);
+}
+
+
+/**
+ * Lectura de todo el puerto de una vez (el LPC2105 solo tiene P0)
+ */
+uint32_t hal_gpio_leer_puerto(uint8_t puerto){
+	return (puerto == 0) ? IOPIN : 0;
+}
+
+
 /**
  * Escribe en el gpio el valor
  */
@@ -56,5 +76,25 @@ void hal_gpio_escribir(HAL_GPIO_PIN_T gpio, uint32_t valor){
 	else IOSET = masc;
 }
 
+/**
+ * Escribe varios pines del puerto: IOSET e IOCLR seguidos, sin lectura previa
+ */
+void hal_gpio_escribir_puerto(uint8_t puerto, uint32_t mascara, uint32_t valores){
+	if (puerto != 0) return;
+	IOSET = mascara & valores;
+	IOCLR = mascara & ~valores;
+}
 
+/**
+ * Sin PPI: el marco lo escribe drv_leds desde la IRQ de un canal de tiempo
+ */
+bool hal_gpio_marco_armar(uint8_t disparo, const HAL_GPIO_PIN_T *pines, uint8_t num, uint32_t niveles){
+	(void)disparo;
+	(void)pines;
+	(void)num;
+	(void)niveles;
+	return false;
+}
 
+void hal_gpio_marco_cancelar(void){
+}
@@ -16,14 +16,58 @@ void hal_sonido_iniciar(void) {
 }
 
 /**
- * @brief Genera un tono (stub para LPC).
+ * @brief Arranca un tono (stub para LPC).
  * 
  * @param frecuencia_hz No utilizado.
- * @param duracion_ms No utilizado.
  */
-void hal_sonido_tocar(uint32_t frecuencia_hz, uint32_t duracion_ms) {
+void hal_sonido_iniciar_tono(uint32_t frecuencia_hz) {
     // Stub: Sin implementación para LPC2105
     (void)frecuencia_hz;
-    (void)duracion_ms;
     ;
 }
+
+/**
+ * @brief Detiene el tono (stub para LPC).
+ */
+void hal_sonido_parar(void) {
+    // Stub: Sin implementación para LPC2105
+    ;
+}
+
+/**
+ * @brief Sin PWM con DMA: la secuencia la lleva el driver nota a nota.
+ */
+bool hal_sonido_secuencia(const hal_sonido_nota_t *notas, uint8_t num_notas, void (*fin_cb)(void)) {
+    (void)notas;
+    (void)num_notas;
+    (void)fin_cb;
+    return false;
+}
+
+/**
+ * @brief Sin PWM con DMA no hay salida PCM.
+ */
+uint32_t hal_sonido_pcm(bool (*rellenar)(uint16_t *bloque, uint32_t n)) {
+    (void)rellenar;
+    return 0;
+}
+
+/**
+ * @brief Sin PPI no hay click disparado por hardware.
+ */
+bool hal_sonido_click_armar(uint8_t disparo, uint32_t frecuencia_hz, uint32_t duracion_ms) {
+    (void)disparo;
+    (void)frecuencia_hz;
+    (void)duracion_ms;
+    return false;
+}
+
+void hal_sonido_click_cancelar(void) {
+}
+
+/**
+ * @brief Sin salida de sonido en esta placa.
+ */
+bool hal_sonido_activo(void) {
+    return false;
+}
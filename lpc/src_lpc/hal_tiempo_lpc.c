@@ -5,6 +5,7 @@
  
 #include <LPC210x.H>
 #include "hal_tiempo.h"
+#include "board.h"
 #include <stdlib.h>
 #define PCLK_MHZ          15u
 #define TICKS_PER_US      PCLK_MHZ
@@ -15,10 +16,32 @@
 static volatile uint32_t s_overflows_t1 = 0;  /* cuenta desbordes de T1 */
 static hal_tiempo_info_t s_info;
 
+/* ---- Alarma one-shot con T1 MR1 ------------------------------------------ */
+static void (* volatile s_cb_alarma)() = 0;  /* NULL si no hay alarma armada */
+static volatile uint64_t s_alarma_tick = 0;   /* instante absoluto de disparo */
+
+#define T1_MR1_INT        (1u << 3)           /* bit MR1I de T1MCR */
+
+static void canales_iniciar(void);
+
 void T1_ISR(void) __irq {
-    /* Match0 al mximo para provocar overflow controlado */
-    T1IR = 1;                  /* clear MR0 int */
-    s_overflows_t1++;
+    if (T1IR & 0x02) {
+        T1IR = 0x02;           /* clear MR1 int (alarma) */
+    }
+    if (T1IR & 0x01) {
+        /* Match0 al mximo para provocar overflow controlado */
+        T1IR = 0x01;           /* clear MR0 int */
+        s_overflows_t1++;
+    }
+    VICSoftIntClear = (1u << 5); /* por si la alarma se forzo por software */
+
+    /* MR1 solo compara 32 bits: comprobamos el instante completo de 64 */
+    if (s_cb_alarma && hal_tiempo_actual_tick64() >= s_alarma_tick) {
+        void (*cb)() = s_cb_alarma;
+        s_cb_alarma = 0;
+        T1MCR &= ~T1_MR1_INT;
+        cb();
+    }
     VICVectAddr = 0;
 }
 
@@ -38,6 +61,8 @@ void hal_tiempo_iniciar_tick(hal_tiempo_info_t *out_info) {
     T1TCR = 2;  /* reset */
     T1TCR = 1;  /* start */
 
+    canales_iniciar();         /* T0 libre para los canales */
+
     s_info.ticks_per_us   = TICKS_PER_US;
     s_info.counter_bits   = COUNTER_BITS;
     s_info.counter_max    = COUNTER_MAX;
@@ -62,58 +87,180 @@ uint64_t hal_tiempo_actual_tick64(void) {
 
 /* ***************************************************************************** */
 
-/* ---- Reloj peridico con T0 ---------------------------------------------- */
-static void (*s_cb)() = 0;		//puntero a funcion a llamar cuando salte la RSI (en modo irq)
+/* ---- Canales con T0 libre: MR0..MR3 -------------------------------------- */
+/* T0 cuenta sin reset; cada canal compara con su MR y se re-arma sumando el periodo */
+#define T0_MR_INT(c)      (1u << (3u * (c)))  /* bit MRnI de T0MCR */
+
+#define T0_MR(c)          ((&T0MR0)[(c)])      /* T0MR0..T0MR3 son consecutivos */
+static void (*s_cb_canal[HAL_TIEMPO_CANALES])(uint8_t canal);
+static uint32_t s_periodo_canal[HAL_TIEMPO_CANALES];
+static bool s_periodico_canal[HAL_TIEMPO_CANALES];
+static volatile uint32_t s_canales_forzados = 0;   /* matches perdidos, atendidos por software */
+
+/* MR = desde + periodo; si TC ya lo rebaso no habria match hasta la siguiente vuelta */
+static void canal_programar(uint8_t canal, uint32_t desde) {
+    T0_MR(canal) = desde + s_periodo_canal[canal];
+    if ((uint32_t)(T0TC - desde) >= s_periodo_canal[canal]) {
+        s_canales_forzados |= (1u << canal);
+        VICSoftInt = (1u << 4);
+    }
+}
 
 /* *****************************************************************************
  * Timer Interrupt Service Routine
- * llama a la funcion de callbak que se ejecutara en modo irq
+ * llama al callback de cada canal vencido (en modo irq)
  */
-
 void T0_ISR(void) __irq {
-    if (s_cb) s_cb();						// Llamo a la funcin desde la RSI.
-    T0IR = 1;										// Clear interrupt flag
-    VICVectAddr = 0;						// Acknowledge Interrupt
+    uint32_t vencidos = (T0IR & 0x0Fu) | s_canales_forzados;
+
+    T0IR = vencidos & 0x0Fu;                /* clear MRn int */
+    s_canales_forzados = 0;
+    VICSoftIntClear = (1u << 4);
+
+    for (uint8_t c = 0; c < HAL_TIEMPO_CANALES; c++) {
+        if ((vencidos & (1u << c)) == 0 || (T0MCR & T0_MR_INT(c)) == 0) continue;
+        if (s_periodico_canal[c]) {
+            canal_programar(c, T0_MR(c));    /* desde el match anterior: sin deriva */
+        } else {
+            T0MCR &= ~T0_MR_INT(c);
+        }
+        if (s_cb_canal[c]) s_cb_canal[c](c);
+    }
+    VICVectAddr = 0;                        // Acknowledge Interrupt
 }
 
-void hal_tiempo_periodico_config_tick(uint32_t periodo_en_tick) {
-    /* Config sin arrancar */
-    T0TCR = 0;
-    if (periodo_en_tick == 0) return;
-    T0MR0 = periodo_en_tick - 1u;
-    T0MCR = 3; /* int + reset */
+static void canales_iniciar(void) {
+    T0TCR = 2;                 /* reset */
+    T0PR = 0;
+    T0MCR = 0;                 /* sin reset por match: contador libre */
+    T0IR = 0x0F;
     VICVectAddr0 = (unsigned long)T0_ISR;
-    VICVectCntl0 = 0x20 | 4;  /* fuente 4 = Timer0 */
+    VICVectCntl0 = 0x20 | 4;   /* fuente 4 = Timer0 */
+    VICIntEnable |= (1u << 4);
+    T0TCR = 1;                 /* start */
+}
+
+void hal_tiempo_canal_config_tick(uint8_t canal, uint32_t periodo_en_tick, bool periodico) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    /* Config sin arrancar */
+    T0MCR &= ~T0_MR_INT(canal);
+    s_periodo_canal[canal] = periodo_en_tick;
+    s_periodico_canal[canal] = periodico;
 }
 
-void hal_tiempo_periodico_set_callback(void (*cb)()) {
-    s_cb = cb;
+void hal_tiempo_canal_set_callback(uint8_t canal, void (*cb)(uint8_t canal)) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    s_cb_canal[canal] = cb;
 }
 
-void hal_tiempo_periodico_enable(bool enable) {
-    if (enable) {
-        VICIntEnable |= (1u << 4);
-        T0TCR = 2; T0TCR = 1;
-    } else {
-        T0TCR = 0;
-        VICIntEnClr = (1u << 4);
+void hal_tiempo_canal_enable(uint8_t canal, bool enable) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    T0MCR &= ~T0_MR_INT(canal);
+    s_canales_forzados &= ~(1u << canal);
+    T0IR = (1u << canal);
+    if (enable && s_periodo_canal[canal] != 0) {
+        canal_programar(canal, T0TC);
+        T0MCR |= T0_MR_INT(canal);
     }
 }
 
-void hal_tiempo_reloj_periodico_tick(uint32_t periodo_en_tick, void (*funcion_callback_drv)(void)){
+void hal_tiempo_canal_tick(uint8_t canal, uint32_t periodo_en_tick, bool periodico, void (*funcion_callback_drv)(uint8_t canal)) {
     /* 1) Deshabilitar antes de tocar config/callback (evita ISR en mitad de cambios) */
-    hal_tiempo_periodico_enable(false);
+    hal_tiempo_canal_enable(canal, false);
 
     /* 2) Registrar callback (puede ser NULL si vamos a deshabilitar) */
-    hal_tiempo_periodico_set_callback(funcion_callback_drv);
+    hal_tiempo_canal_set_callback(canal, funcion_callback_drv);
 
-    /* 3) Configurar periodo (no arranca el temporizador) */
-    hal_tiempo_periodico_config_tick(periodo_en_tick);
+    /* 3) Configurar periodo (no arranca el canal) */
+    hal_tiempo_canal_config_tick(canal, periodo_en_tick, periodico);
 
-    /* 4) Habilitar si hay periodo vlido y callback no nulo; deshabilitar en caso contrario */
+    /* 4) Habilitar si hay periodo valido y callback no nulo */
     if (periodo_en_tick != 0u && funcion_callback_drv != NULL) {
-        hal_tiempo_periodico_enable(true);
-    } else {
-        hal_tiempo_periodico_enable(false);
+        hal_tiempo_canal_enable(canal, true);
+    }
+}
+
+/* ***************************************************************************** */
+
+/* ---- Alarma one-shot con T1 MR1 ------------------------------------------ */
+
+void hal_tiempo_alarma_tick(uint64_t deadline_tick, void (*funcion_callback_drv)()) {
+    T1MCR &= ~T1_MR1_INT;                 /* desarmar mientras se reconfigura */
+    s_cb_alarma = 0;
+    if (funcion_callback_drv == NULL) return;
+
+    s_alarma_tick = deadline_tick;
+    s_cb_alarma = funcion_callback_drv;
+    T1MR1 = (uint32_t)deadline_tick;      /* el match salta en cada vuelta, la ISR filtra */
+    T1IR = 0x02;
+    T1MCR |= T1_MR1_INT;                  /* int on MR1, sin reset */
+
+    /* si el instante ya paso (o paso mientras configurabamos) forzamos la IRQ */
+    if (hal_tiempo_actual_tick64() >= deadline_tick) {
+        VICSoftInt = (1u << 5);
     }
 }
+
+void hal_tiempo_alarma_cancelar(void) {
+    T1MCR &= ~T1_MR1_INT;
+    s_cb_alarma = 0;
+    T1IR = 0x02;
+}
+
+/* T0 y T1 cuentan a PCLK: lo que le falta a un match de T0 vale igual en ticks de T1 */
+uint64_t hal_tiempo_proximo_tick(void) {
+    uint64_t ahora = hal_tiempo_actual_tick64();
+    uint64_t proximo = s_cb_alarma ? s_alarma_tick : HAL_TIEMPO_NUNCA;
+    uint32_t tc = T0TC;
+
+    for (uint8_t c = 0; c < HAL_TIEMPO_CANALES; c++) {
+        if ((T0MCR & T0_MR_INT(c)) == 0) continue;
+        if (s_canales_forzados & (1u << c)) return ahora;
+        uint64_t t = ahora + (uint32_t)(T0_MR(c) - tc);
+        if (t < proximo) proximo = t;
+    }
+    return proximo;
+}
+
+/* T1 ya cuenta a PCLK: no hay reloj rapido que encender */
+void hal_tiempo_reloj_rapido(bool encender) {
+    (void)encender;
+}
+
+void hal_tiempo_alta_resolucion(bool activar) {
+    (void)activar;
+}
+
+/* Los EINT no pueden disparar CAP de T1: sin captura hardware de flancos */
+uint32_t hal_tiempo_captura_tarea(uint8_t n) {
+    (void)n;
+    return 0;
+}
+
+bool hal_tiempo_captura_tick64(uint8_t n, uint64_t *tick) {
+    (void)n;
+    (void)tick;
+    return false;
+}
+
+/* Sin PPI: un match de T1 no puede arrancar otro periferico */
+uint32_t hal_tiempo_disparo_evento(uint8_t n) {
+    (void)n;
+    return 0;
+}
+
+bool hal_tiempo_disparo_tick(uint8_t n, uint64_t deadline_tick) {
+    (void)n;
+    (void)deadline_tick;
+    return false;
+}
+
+bool hal_tiempo_disparo_saltado(uint8_t n) {
+    (void)n;
+    return false;
+}
+
+/* Sin contador de ciclos en el ARM7: tick de T1 (PCLK = CCLK/4) escalado a ciclos */
+uint32_t hal_tiempo_ciclos(void) {
+    return (uint32_t)hal_tiempo_actual_tick64() * (CPU_CLOCK_MHZ / TICKS_PER_US);
+}
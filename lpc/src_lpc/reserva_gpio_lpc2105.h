@@ -18,6 +18,7 @@ enum { 	LED1_GPIO = 0,
 enum {  INT_EXT1 = 14, //eINT1
 				INT_EXT2 = 15, //eINT2
 				INT_EXT3 = 16, //eINT0
+				BOTON4_GPIO = 17, //GPIO sin EINT: solo con DRV_BOTONES_SONDEO
 };
 // MONITORES
 enum { 	MONITOR1_GPIO = 28,
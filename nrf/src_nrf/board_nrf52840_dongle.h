@@ -38,4 +38,24 @@
 #define BUTTONS_LIST { BUTTON_1 }
 #endif //botonos
 
+// Canales de eventos hardware reservados (GPIOTE / PPI)
+#define GPIOTE_CANAL_BOTONES   0   // GPIOTE CONFIG[0..BUTTONS_NUMBER-1]: flanco de cada boton
+#define PPI_CANAL_BOTONES      0   // PPI CH[0..BUTTONS_NUMBER-1]: flanco -> captura de TIMER4
+#define PPI_GRUPO_BOTONES      0   // grupos PPI 0..BUTTONS_NUMBER-1: solo el primer flanco
+#define PPI_CANAL_SYNC_CAPTURA 4   // PPI CH[4]: EGU0 -> captura simultanea TIMER1/TIMER4
+#define PPI_CANAL_METRONOMO    5   // PPI CH[5]: disparo de TIMER4 -> arranque del click en PWM0
+#define GPIOTE_CANAL_LEDS      4   // GPIOTE CONFIG[4..7]: LEDs en modo tarea (marcos de drv_leds)
+#define PPI_CANAL_LEDS         6   // PPI CH[6..7]: disparo de TIMER4 -> SET/CLR de los LEDs (TEP + FORK)
+
+// FLASH: region reservada para svc_almacen (el bootloader del dongle empieza en 0xE0000)
+#define FLASH_ALMACEN_DIR      0xDE000  // 2 paginas de 4 KB justo debajo del bootloader
+#define FLASH_ALMACEN_PAGINAS  2
+
+// CONSUMO: dormido este tiempo sin botones se pasa a System OFF (el boton arranca en frio)
+#define CONSUMO_APAGAR_TRAS_S  600
+
+//TIEMPO
+#define CPU_CLOCK_MHZ      64   // HCLK del Cortex-M4
+#define TIMER_TICKS_PER_US 16   // TIMERx con PRESCALER 0 (16 MHz)
+
 #endif
@@ -0,0 +1,29 @@
+/* *****************************************************************************
+ * HAL de secciones críticas para nRF52 (Cortex-M4): BASEPRI en lugar de PRIMASK.
+ * Solo se bloquean las IRQ que comparten datos con el runtime; las de
+ * HAL_SC_PRIORIDAD_CRITICA siguen entrando dentro de la sección.
+ * ****************************************************************************/
+#include "hal_SC.h"
+#include <nrf.h>
+
+#define NRF_IRQS   48u      // IRQ de periférico del nRF52840 (0..47)
+
+/* BASEPRI solo mira los __NVIC_PRIO_BITS altos del byte */
+#define TECHO_BASEPRI  (HAL_SC_PRIORIDAD_RUNTIME << (8u - __NVIC_PRIO_BITS))
+
+void hal_SC_iniciar(void) {
+    for (uint32_t i = 0; i < NRF_IRQS; i++) {
+        NVIC_SetPriority((IRQn_Type)i, HAL_SC_PRIORIDAD_RUNTIME);
+    }
+}
+
+uint32_t hal_SC_entrar(void) {
+    uint32_t previo = __get_BASEPRI();
+    __set_BASEPRI_MAX(TECHO_BASEPRI);   // no baja un techo más restrictivo ya puesto
+    __ISB();
+    return previo;
+}
+
+void hal_SC_salir(uint32_t estado) {
+    __set_BASEPRI(estado);
+}
@@ -6,85 +6,260 @@
 
 #include "hal_consumo.h"
 #include "board.h"
+#include "hal_tiempo.h"
+#include "hal_WDT.h"
 #include <nrf.h> // Fichero CMSIS de Nordic, que define __WFI()
 
+/* Dormir profundo: System ON con la CPU parada, solo despiertan los botones.
+ * Sigue encendido el LFCLK (base de tiempo con HAL_TIEMPO_RTC y RTC0 del perro).
+ * El WDT no se puede parar una vez arrancado: RTC0 despierta cada medio segundo
+ * para alimentarlo, sin ejecutar ninguna ISR. */
+#define PERRO_PRESCALER    4095u    // RTC0 a 8 Hz
+#define PERRO_CUENTAS      4u       // 0.5 s (el WDT salta a 1 s)
+
+/* Tras CONSUMO_APAGAR_TRAS_S dormido sin botones se pasa a System OFF: RAM y perro
+ * apagados (~0.4 uA). El botón que despierte arranca desde main() y queda en LATCH */
+#define PERRO_VUELTAS_APAGAR ((CONSUMO_APAGAR_TRAS_S * (32768u / (PERRO_PRESCALER + 1u))) / PERRO_CUENTAS)
+
+#if defined(HAL_TIEMPO_RTC)
+#define IRQ_BASE_TIEMPO    RTC1_IRQn    // desbordes de 24 bits y alarma
+#else
+#define IRQ_BASE_TIEMPO    TIMER1_IRQn
+#endif
+
+/* RAM: RAM[0..7] con 2 secciones de 4 KB, RAM[8] con 6 de 32 KB. Las secciones por
+ * encima de lo que usa el programa (datos, pila y heap: todo en RW_IRAM1) se
+ * apagan mientras se duerme; el resto se retiene. */
+#define RAM_BASE           0x20000000u
+#define RAM_BLOQUES        9u
+extern uint32_t Image$$RW_IRAM1$$ZI$$Limit;
+static uint32_t s_ram_apagada[RAM_BLOQUES];
+
+static void ram_apagar_sin_uso(void) {
+    uint32_t usada = (uint32_t)&Image$$RW_IRAM1$$ZI$$Limit;
+
+    for (uint32_t n = 0; n < RAM_BLOQUES; n++) {
+        uint32_t secciones = (n < 8) ? 2u : 6u;
+        uint32_t tam = (n < 8) ? 0x1000u : 0x8000u;
+        uint32_t base = (n < 8) ? RAM_BASE + n * 0x2000u : RAM_BASE + 0x10000u;
+        uint32_t mascara = 0;
+        for (uint32_t i = 0; i < secciones; i++) {
+            if (base + i * tam >= usada) mascara |= 1u << i;    // SiPOWER
+        }
+        s_ram_apagada[n] = mascara;
+        if (mascara) NRF_POWER->RAM[n].POWERCLR = mascara;
+    }
+}
+
+static void ram_encender(void) {
+    for (uint32_t n = 0; n < RAM_BLOQUES; n++) {
+        if (s_ram_apagada[n]) NRF_POWER->RAM[n].POWERSET = s_ram_apagada[n];
+    }
+}
+
+// KB que deja apagados el último ram_apagar_sin_uso
+static uint32_t ram_kb_apagados(void) {
+    uint32_t kb = 0;
+    for (uint32_t n = 0; n < RAM_BLOQUES; n++) {
+        for (uint32_t m = s_ram_apagada[n]; m != 0; m &= m - 1u) kb += (n < 8) ? 4u : 32u;
+    }
+    return kb;
+}
+
+/* Cifras de la hoja de datos del nRF52840 (Product Specification, consumos):
+ * CPU a 64 MHz desde flash con caché y LDO (I_CPU,FLASH): 6.3 mA.
+ * System ON sin RAM retenida (I_ON_RAMOFF_EVENT): 0.97 uA.
+ * System ON con los 256 KB retenidos (I_ON_RAMON_EVENT): 2.35 uA.
+ * Retener RAM cuesta (2.35 - 0.97) uA / 256 KB. */
+#define CPU_ACTIVA_UA          6300u
+#define RAM_RETENCION_NA_256K  1380u
+
+
+/* System OFF: solo el DETECT de los botones (SENSE bajo) despierta, con un reset.
+ * El LATCH no se limpia: la ISR de GPIOTE lo deja vacío y con una pulsación pendiente
+ * no se llega aquí, así que al arrancar solo tiene el pin que despertó */
+static void apagar(void) {
+    static const uint32_t botones[BUTTONS_NUMBER] = BUTTONS_LIST;
+
+    for (uint32_t i = 0; i < BUTTONS_NUMBER; i++) {
+        if (botones[i] >= 32) continue;
+        // Un botón a medio antirrebote tiene el SENSE quitado
+        uint32_t cnf = NRF_P0->PIN_CNF[botones[i]] & ~GPIO_PIN_CNF_SENSE_Msk;
+        NRF_P0->PIN_CNF[botones[i]] = cnf | (GPIO_PIN_CNF_SENSE_Low << GPIO_PIN_CNF_SENSE_Pos);
+    }
+    NRF_POWER->SYSTEMOFF = 1;
+    __DSB();
+    while (1) __WFE();     // no se vuelve: el siguiente arranque es desde main()
+}
+
+
 /* *****************************************************************************
 * Inicializa el subsistema de consumo
 */
 void hal_consumo_iniciar(void) {
-    /* YA LO HACEMOS EN DORMIR, AQUÍ NO HARÍA FALTA!!!!
-    // 1. Configurar los 4 botones como pines de "despertar" (wake-up).
-    //    Para despertar de System OFF, el nRF usa la detección de nivel (SENSE).
-    
-    #if (BUTTON_PULL == 1)
-        #define _PULL_CONFIG (GPIO_PIN_CNF_PULL_Pullup << GPIO_PIN_CNF_PULL_Pos)
-    #else
-        #define _PULL_CONFIG (GPIO_PIN_CNF_PULL_Disabled << GPIO_PIN_CNF_PULL_Pos)
-    #endif
-
-    const uint32_t WAKEUP_PIN_CNF = 
-        (GPIO_PIN_CNF_DIR_Input << GPIO_PIN_CNF_DIR_Pos) |
-        (GPIO_PIN_CNF_INPUT_Connect << GPIO_PIN_CNF_INPUT_Pos) |
-        _PULL_CONFIG |
-        (GPIO_PIN_CNF_SENSE_Low << GPIO_PIN_CNF_SENSE_Pos); // <-- Clave: despertar por nivel bajo
-
-    // Asumimos que todos los botones están en el Puerto 0 (como en la DK)
-    NRF_P0->PIN_CNF[BUTTON_1] = WAKEUP_PIN_CNF;
-    NRF_P0->PIN_CNF[BUTTON_2] = WAKEUP_PIN_CNF;
-    NRF_P0->PIN_CNF[BUTTON_3] = WAKEUP_PIN_CNF;
-    NRF_P0->PIN_CNF[BUTTON_4] = WAKEUP_PIN_CNF;
-    */
+#if !defined(HAL_TIEMPO_RTC)
+    // RTC0 cuenta con el LFCLK: sin la base de tiempo RTC nadie más lo arranca
+    NRF_CLOCK->LFCLKSRC = (CLOCK_LFCLKSRC_SRC_Xtal << CLOCK_LFCLKSRC_SRC_Pos);
+    NRF_CLOCK->EVENTS_LFCLKSTARTED = 0;
+    NRF_CLOCK->TASKS_LFCLKSTART = 1;
+    while (NRF_CLOCK->EVENTS_LFCLKSTARTED == 0) {}
+#endif
+    // RTC0 solo se usa para alimentar al perro mientras se duerme
+    NRF_RTC0->TASKS_STOP = 1;
+    NRF_RTC0->PRESCALER = PERRO_PRESCALER;
+    NRF_RTC0->CC[0] = PERRO_CUENTAS;
+    NRF_RTC0->INTENSET = RTC_INTENSET_COMPARE0_Msk;    // marca pendiente en el NVIC, sin habilitarla
+    NVIC_DisableIRQ(RTC0_IRQn);
 }
 
 /* *****************************************************************************
 * Detiene la CPU hasta la próxima interrupción
 */
 void hal_consumo_esperar(void) {
-    //Instrucción Wait For Interrupt, para que el procesador se duerma hasta recibir una interrupción
-    //Al despertar, continua la ehecución en la siguiente línea de código
+    uint32_t techo = __get_BASEPRI();
+    if (techo == 0) {
+        //Instrucción Wait For Interrupt, para que el procesador se duerma hasta recibir una interrupción
+        //Al despertar, continua la ehecución en la siguiente línea de código
+        __WFI();
+        return;
+    }
+    // Dentro de una sección crítica (hal_SC) una IRQ por debajo de BASEPRI no despierta
+    // a WFI; con PRIMASK sí despierta aunque no se atienda hasta salir
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    __set_BASEPRI(0);
     __WFI();
+    __set_BASEPRI(techo);
+    __set_PRIMASK(primask);
 }
 
 /* *****************************************************************************
-* Detiene la CPU hasta la próxima interrupción (dormir profundo).
+* Coste de los niveles de reposo. LENTO: el reloj rápido ya está apagado (nadie lo
+* ha pedido), no hay nada que arrancar al volver.
+* PROFUNDO: se mide una vez con hal_tiempo_ciclos el camino real, apagar y encender
+* la RAM sin uso (está sin uso: se puede hacer despierto).
+*  - latencia: lo que tarda ram_encender tras el WFI.
+*  - equilibrio: los dos recorridos a CPU_ACTIVA_UA, pagados con lo que se deja de
+*    retener (RAM_RETENCION_NA_256K por cada 256 KB apagados). Con ~20 KB en uso y
+*    unos pocos cientos de ciclos sale del orden de decenas de ms.
 */
-void hal_consumo_dormir(void) {
-    
-    // 1. Configurar los 4 botones como pines de "despertar" (wake-up).
-    //    Para despertar de System OFF, el nRF usa la detección de nivel (SENSE).
-    //    Configuramos SENSE_Low en los 4 pines de los botones.
-    
-    #if (BUTTON_PULL == 1)
-        #define _PULL_CONFIG (GPIO_PIN_CNF_PULL_Pullup << GPIO_PIN_CNF_PULL_Pos)
-    #else
-        #define _PULL_CONFIG (GPIO_PIN_CNF_PULL_Disabled << GPIO_PIN_CNF_PULL_Pos)
-    #endif
-
-    const uint32_t WAKEUP_PIN_CNF = 
-        (GPIO_PIN_CNF_DIR_Input << GPIO_PIN_CNF_DIR_Pos) |
-        (GPIO_PIN_CNF_INPUT_Connect << GPIO_PIN_CNF_INPUT_Pos) |
-        _PULL_CONFIG |
-        (GPIO_PIN_CNF_SENSE_Low << GPIO_PIN_CNF_SENSE_Pos); // <-- Clave: despertar por nivel bajo
-
-    // Asumimos que todos los botones están en el Puerto 0 (como en la DK)
-    NRF_P0->PIN_CNF[BUTTON_1] = WAKEUP_PIN_CNF;
-    NRF_P0->PIN_CNF[BUTTON_2] = WAKEUP_PIN_CNF;
-    NRF_P0->PIN_CNF[BUTTON_3] = WAKEUP_PIN_CNF;
-    NRF_P0->PIN_CNF[BUTTON_4] = WAKEUP_PIN_CNF;
-
-    // 2. Limpiar el LATCH de los pines por si hubiera una detección pendiente
-    //    (Evita un despertar/reinicio inmediato)
-    NRF_P0->LATCH = (1UL << BUTTON_1) | (1UL << BUTTON_2) | (1UL << BUTTON_3) | (1UL << BUTTON_4);
-
-    // 3. Activar el modo System OFF
-    //    (No retenemos la RAM, cumpliendo "perdiendo el estado")
-    NRF_POWER->SYSTEMOFF = 1;
+void hal_consumo_coste(hal_consumo_nivel_t nivel, hal_consumo_coste_t *coste) {
+    coste->disponible = true;
+    coste->equilibrio_us = 0;
+    coste->latencia_us = 0;
+    switch (nivel) {
+        case HAL_CONSUMO_ESPERAR:
+            break;
+#if defined(HAL_TIEMPO_RTC)
+        case HAL_CONSUMO_LENTO:
+            break;
+#endif
+        case HAL_CONSUMO_PROFUNDO:
+        {
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            uint32_t t0 = hal_tiempo_ciclos();
+            ram_apagar_sin_uso();
+            uint32_t t1 = hal_tiempo_ciclos();
+            ram_encender();
+            uint32_t t2 = hal_tiempo_ciclos();
+            __set_PRIMASK(primask);
+
+            uint32_t ahorro_na = ram_kb_apagados() * RAM_RETENCION_NA_256K / 256u;
+            if (ahorro_na == 0) {
+                coste->disponible = false;     // toda la RAM en uso: no hay nada que apagar
+                break;
+            }
+            // uA * us (carga en pC) de los dos recorridos; entre nA da us
+            uint32_t carga = (t2 - t0) * CPU_ACTIVA_UA / CPU_CLOCK_MHZ;
+            coste->equilibrio_us = carga * 1000u / ahorro_na;
+            coste->latencia_us = (t2 - t1) / CPU_CLOCK_MHZ + 1u;
+            break;
+        }
+        default:
+            coste->disponible = false;
+            break;
+    }
+}
+
+/* *****************************************************************************
+* WFI con la RAM sin uso apagada. PRIMASK retiene la IRQ que despierta hasta que
+* la RAM vuelve a estar encendida; no se enmascara nada en el NVIC.
+*/
+void hal_consumo_esperar_profundo(void) {
+    __disable_irq();
+    ram_apagar_sin_uso();
+    __DSB();
+    __WFI();
+    ram_encender();
+    __enable_irq();
+}
+
+/* *****************************************************************************
+* Dormir profundo conservando el estado: vuelve cuando un botón despierta.
+* Solo la IRQ de la base de tiempo queda habilitada en el NVIC: se atiende en el
+* momento (no puede perder desbordes) y se vuelve a dormir. La de los botones
+* también está enmascarada: con SEVONPEND despierta a WFE y su bit de pendiente
+* sigue ahí para salir del bucle (si su ISR corriera en la ventana lo borraría).
+* Lo demás que se marque mientras tanto se atiende al volver.
+*/
+uint32_t hal_consumo_dormir(void) {
+    uint32_t activas[2] = { NVIC->ISER[0], NVIC->ISER[1] };
+
+    __disable_irq();
+    NVIC->ICER[0] = activas[0];
+    NVIC->ICER[1] = activas[1];
+    NVIC_EnableIRQ(IRQ_BASE_TIEMPO);
+
+    // Con SEVONPEND una IRQ pendiente despierta a WFE aunque no esté habilitada (RTC0, GPIOTE)
+    SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+    NRF_RTC0->EVENTS_COMPARE[0] = 0;
+    NRF_RTC0->TASKS_CLEAR = 1;
+    NRF_RTC0->TASKS_START = 1;
+    ram_apagar_sin_uso();
+
+    uint32_t vueltas = 0;
+    while (!NVIC_GetPendingIRQ(GPIOTE_IRQn)) {
+        __WFE();
+        if (NRF_RTC0->EVENTS_COMPARE[0]) {
+            NRF_RTC0->EVENTS_COMPARE[0] = 0;
+            NRF_RTC0->TASKS_CLEAR = 1;
+            hal_WDT_feed();
+            if (++vueltas >= PERRO_VUELTAS_APAGAR) apagar();
+        }
+        NVIC_ClearPendingIRQ(RTC0_IRQn);
+        // Ventana para la ISR de la base de tiempo si es ella la que ha despertado
+        __enable_irq();
+        __ISB();
+        __disable_irq();
+    }
+    uint32_t despierto = hal_tiempo_ciclos();
+
+    ram_encender();
+    NRF_RTC0->TASKS_STOP = 1;
+    NVIC_ClearPendingIRQ(RTC0_IRQn);
+    SCB->SCR &= ~SCB_SCR_SEVONPEND_Msk;
+    NVIC->ISER[0] = activas[0];
+    NVIC->ISER[1] = activas[1];
+
+    // Aquí entra la IRQ del botón: la pulsación que despierta sigue el camino normal
+    // de drv_botones y llega como ev_PULSAR_BOTON
+    __enable_irq();
+    return despierto;
+}
+
+/* *****************************************************************************
+* Causa del arranque: RESETREAS acumula hasta que se escribe, se limpia al leerla
+*/
+uint32_t hal_consumo_causa_arranque(void) {
+    uint32_t reg = NRF_POWER->RESETREAS;
+    uint32_t causa = 0;
 
-    // 4. Esperar a que el sistema se apague.
-    //    Un WFI final asegura que la CPU se detiene.
-    //    El código NUNCA retornará de aquí.
-    __WFE();
-    
-    // El sistema se reiniciará desde main() al pulsar un botón.
-    while(1);
+    NRF_POWER->RESETREAS = reg;
+    if (reg & POWER_RESETREAS_RESETPIN_Msk) causa |= HAL_CONSUMO_ARRANQUE_PIN;
+    if (reg & POWER_RESETREAS_DOG_Msk)      causa |= HAL_CONSUMO_ARRANQUE_PERRO;
+    if (reg & (POWER_RESETREAS_SREQ_Msk | POWER_RESETREAS_LOCKUP_Msk)) causa |= HAL_CONSUMO_ARRANQUE_SOFTWARE;
+    if (reg & POWER_RESETREAS_OFF_Msk)      causa |= HAL_CONSUMO_ARRANQUE_DESPERTAR;
+    // Sin ningún bit: arranque por alimentación
+    return causa ? causa : HAL_CONSUMO_ARRANQUE_ENCENDIDO;
 }
@@ -3,6 +3,8 @@
  * ****************************************************************************/
 
 #include "hal_ext_int.h"
+#include "hal_tiempo.h"
+#include "board.h"
 #include <nrf.h>
 #include <stddef.h>
 
@@ -20,6 +22,40 @@ static const uint32_t PIN_CNF_DEF =
     (GPIO_PIN_CNF_PULL_Pullup      << GPIO_PIN_CNF_PULL_Pos)  |
     (GPIO_PIN_CNF_SENSE_Disabled   << GPIO_PIN_CNF_SENSE_Pos);
 
+// Captura del flanco: la IRQ sigue viniendo de PORT (SENSE); en paralelo cada
+// boton tiene un canal GPIOTE IN cuyo evento, via PPI, captura TIMER4 sin CPU.
+// El FORK del mismo canal PPI deshabilita su grupo: solo cuenta el primer flanco.
+static bool captura_disponible(uint32_t id_linea)
+{
+    return id_linea < HAL_TIEMPO_CAPTURAS && hal_tiempo_captura_tarea(id_linea) != 0;
+}
+
+static void captura_configurar(uint8_t id_linea, uint32_t pin)
+{
+    if (!captura_disponible(id_linea)) return;
+    uint8_t gpiote = GPIOTE_CANAL_BOTONES + id_linea;
+    uint8_t ppi    = PPI_CANAL_BOTONES + id_linea;
+    uint8_t grupo  = PPI_GRUPO_BOTONES + id_linea;
+
+    NRF_GPIOTE->CONFIG[gpiote] =
+        (GPIOTE_CONFIG_MODE_Event      << GPIOTE_CONFIG_MODE_Pos)  |
+        ((pin & 0x1F)                  << GPIOTE_CONFIG_PSEL_Pos)  |
+        ((pin >> 5)                    << GPIOTE_CONFIG_PORT_Pos)  |
+        (GPIOTE_CONFIG_POLARITY_HiToLo << GPIOTE_CONFIG_POLARITY_Pos);
+
+    NRF_PPI->CH[ppi].EEP   = (uint32_t)&NRF_GPIOTE->EVENTS_IN[gpiote];
+    NRF_PPI->CH[ppi].TEP   = hal_tiempo_captura_tarea(id_linea);
+    NRF_PPI->FORK[ppi].TEP = (uint32_t)&NRF_PPI->TASKS_CHG[grupo].DIS;
+    NRF_PPI->CHG[grupo]    = (1UL << ppi);
+}
+
+static void captura_armar(uint32_t id_linea)
+{
+    if (!captura_disponible(id_linea)) return;
+    NRF_GPIOTE->EVENTS_IN[GPIOTE_CANAL_BOTONES + id_linea] = 0;
+    NRF_PPI->TASKS_CHG[PPI_GRUPO_BOTONES + id_linea].EN = 1;
+}
+
 void hal_ext_int_iniciar(hal_ext_int_callback_t callback) 
 {
     s_hal_callback = callback;
@@ -30,6 +66,7 @@ void hal_ext_int_iniciar(hal_ext_int_callback_t callback)
         if (pin < 32) {
             NRF_P0->PIN_CNF[pin] = PIN_CNF_DEF;
         }
+        captura_configurar(i, pin);
     }
 
     NRF_GPIOTE->INTENSET = GPIOTE_INTENSET_PORT_Msk;
@@ -49,6 +86,7 @@ void hal_ext_int_habilitar(uint32_t id_linea)
         cnf |= (GPIO_PIN_CNF_SENSE_Low << GPIO_PIN_CNF_SENSE_Pos);
         NRF_P0->PIN_CNF[pin] = cnf;
     }
+    captura_armar(id_linea);
 }
 
 void hal_ext_int_deshabilitar(uint32_t id_linea)
@@ -74,6 +112,29 @@ void hal_ext_int_limpiar_pendiente(uint32_t id_linea)
     }
 }
 
+bool hal_ext_int_marca_flanco(uint32_t id_linea, uint64_t *tick)
+{
+    if (id_linea >= g_hal_ext_int_num_pines || !captura_disponible(id_linea)) return false;
+    // Sin evento IN no hubo flanco capturado desde que se armo (p.ej. solo SENSE)
+    if (NRF_GPIOTE->EVENTS_IN[GPIOTE_CANAL_BOTONES + id_linea] == 0) return false;
+    return hal_tiempo_captura_tick64((uint8_t)id_linea, tick);
+}
+
+uint32_t hal_ext_int_despertar(void)
+{
+    uint32_t latch = NRF_P0->LATCH;
+    uint32_t lineas = 0;
+
+    for (uint8_t i = 0; i < g_hal_ext_int_num_pines; i++) {
+        uint32_t pin = g_hal_ext_int_pines[i];
+        if (pin < 32 && (latch & (1UL << pin))) {
+            NRF_P0->LATCH = (1UL << pin);
+            lineas |= (1UL << i);
+        }
+    }
+    return lineas;
+}
+
 void hal_ext_int_habilitar_despertar(uint32_t id)    { hal_ext_int_habilitar(id); }
 void hal_ext_int_deshabilitar_despertar(uint32_t id) { hal_ext_int_deshabilitar(id); }
 
@@ -0,0 +1,46 @@
+/* *****************************************************************************
+ * P.H.2025: HAL de flash para nRF52840 (NVMC)
+ * Mientras el NVMC borra o programa, la CPU se detiene al acceder a flash (y el
+ * código corre en flash): las llamadas son bloqueantes por construcción.
+ */
+#include "hal_flash.h"
+#include <nrf.h>
+
+#define FLASH_PAGINA_BYTES 4096u
+
+static void nvmc_esperar(void) {
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) { }
+}
+
+uint32_t hal_flash_tam_pagina(void) {
+    return FLASH_PAGINA_BYTES;
+}
+
+bool hal_flash_borrar_pagina(uint32_t dir) {
+    if (dir % FLASH_PAGINA_BYTES) return false;
+
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Een << NVMC_CONFIG_WEN_Pos;
+    nvmc_esperar();
+    NRF_NVMC->ERASEPAGE = dir;
+    nvmc_esperar();
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+    nvmc_esperar();
+    return true;
+}
+
+bool hal_flash_escribir(uint32_t dir, const uint32_t *datos, uint32_t num) {
+    if (dir & 3u) return false;
+
+    volatile uint32_t *destino = (volatile uint32_t *)dir;
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos;
+    nvmc_esperar();
+    for (uint32_t i = 0; i < num; i++) {
+        // 0xFFFFFFFF no cambia nada: no se gasta una de las dos escrituras por palabra
+        if (datos[i] == 0xFFFFFFFFu) continue;
+        destino[i] = datos[i];
+        nvmc_esperar();
+    }
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+    nvmc_esperar();
+    return true;
+}
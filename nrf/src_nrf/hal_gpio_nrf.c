@@ -3,8 +3,22 @@
  */
 #include <nrf.h>
 #include "hal_gpio.h"
+#include "hal_tiempo.h"
+#include "board.h"
 #include <stdlib.h>
 
+/* Pines del marco: en modo tarea de GPIOTE (canales GPIOTE_CANAL_LEDS..) desde el
+ * primer armado; ahi el registro OUT ya no manda y se escriben con TASKS_SET/CLR */
+static HAL_GPIO_PIN_T s_marco_pines[HAL_GPIO_MARCO_MAX];
+static uint8_t s_marco_num = 0;
+
+static int marco_canal(HAL_GPIO_PIN_T gpio){
+    for (uint8_t i = 0; i < s_marco_num; i++) {
+        if (s_marco_pines[i] == gpio) return GPIOTE_CANAL_LEDS + i;
+    }
+    return -1;
+}
+
 void hal_gpio_iniciar(void){
   // Reiniciamos pines a entrada (seguro)
   NRF_P0->DIR = 0x00; 
@@ -39,14 +53,102 @@ uint32_t hal_gpio_leer(HAL_GPIO_PIN_T gpio){
 }
 
 
+void hal_gpio_entrada(HAL_GPIO_PIN_T gpio, uint32_t pullup){
+    NRF_GPIO_Type * port = (gpio > 31) ? NRF_P1 : NRF_P0;
+    uint32_t pin = gpio & 0x1F;
+
+    // DIRCLR no basta: tras reset el buffer de entrada esta desconectado (IN no cambia)
+    port->PIN_CNF[pin] =
+        (GPIO_PIN_CNF_DIR_Input        << GPIO_PIN_CNF_DIR_Pos)   |
+        (GPIO_PIN_CNF_INPUT_Connect    << GPIO_PIN_CNF_INPUT_Pos) |
+        ((pullup ? GPIO_PIN_CNF_PULL_Pullup : GPIO_PIN_CNF_PULL_Disabled) << GPIO_PIN_CNF_PULL_Pos) |
+        (GPIO_PIN_CNF_DRIVE_S0S1       << GPIO_PIN_CNF_DRIVE_Pos) |
+        (GPIO_PIN_CNF_SENSE_Disabled   << GPIO_PIN_CNF_SENSE_Pos);
+}
+
+
+uint32_t hal_gpio_leer_puerto(uint8_t puerto){
+    if (puerto == 0) return NRF_P0->IN;
+    if (puerto == 1) return NRF_P1->IN;
+    return 0;
+}
+
+
 void hal_gpio_escribir(HAL_GPIO_PIN_T gpio, uint32_t valor){
     NRF_GPIO_Type * port = (gpio > 31) ? NRF_P1 : NRF_P0;
     uint32_t pin = gpio & 0x1F;
     uint32_t masc = (1UL << pin);
 
+    int canal = marco_canal(gpio);
+
     if (valor == 0 ){
         port->OUTCLR = masc; // Apagamos (o ponemos a 0)
+        if (canal >= 0) NRF_GPIOTE->TASKS_CLR[canal] = 1;
     }else{
         port->OUTSET = masc; // Encendemos (o ponemos a 1)
+        if (canal >= 0) NRF_GPIOTE->TASKS_SET[canal] = 1;
+    }
+}
+
+
+void hal_gpio_escribir_puerto(uint8_t puerto, uint32_t mascara, uint32_t valores){
+    // Con pines de marco de por medio, pin a pin (sus niveles van por GPIOTE)
+    if (s_marco_num > 0) {
+        for (uint32_t pin = 0; pin < 32; pin++) {
+            if (mascara & (1UL << pin)) hal_gpio_escribir((puerto << 5) | pin, (valores >> pin) & 1u);
+        }
+        return;
     }
+    NRF_GPIO_Type * port = (puerto == 1) ? NRF_P1 : NRF_P0;
+    port->OUTSET = mascara & valores;
+    port->OUTCLR = mascara & ~valores;
+}
+
+
+/* *****************************************************************************
+ * Marco de salidas: evento de disparo de hal_tiempo -> PPI -> TASKS_SET/CLR de GPIOTE.
+ * Cada canal PPI lleva dos tareas (TEP + FORK): 4 pines, 2 canales con el mismo EEP.
+ */
+#define MARCO_CANALES_PPI ((HAL_GPIO_MARCO_MAX + 1) / 2)
+
+bool hal_gpio_marco_armar(uint8_t disparo, const HAL_GPIO_PIN_T *pines, uint8_t num, uint32_t niveles){
+    uint32_t evento = hal_tiempo_disparo_evento(disparo);
+    if (evento == 0 || num == 0 || num > HAL_GPIO_MARCO_MAX) return false;
+
+    // Primera vez: cada pin pasa a modo tarea arrancando en el nivel que ya tenia
+    if (s_marco_num != num) {
+        for (uint8_t i = 0; i < num; i++) {
+            NRF_GPIO_Type * port = (pines[i] > 31) ? NRF_P1 : NRF_P0;
+            uint32_t nivel = (port->OUT >> (pines[i] & 0x1F)) & 1u;
+            s_marco_pines[i] = pines[i];
+            NRF_GPIOTE->CONFIG[GPIOTE_CANAL_LEDS + i] =
+                (GPIOTE_CONFIG_MODE_Task       << GPIOTE_CONFIG_MODE_Pos)     |
+                ((pines[i] & 0x1F)             << GPIOTE_CONFIG_PSEL_Pos)     |
+                ((pines[i] >> 5)               << GPIOTE_CONFIG_PORT_Pos)     |
+                (GPIOTE_CONFIG_POLARITY_Toggle << GPIOTE_CONFIG_POLARITY_Pos) |
+                (nivel                         << GPIOTE_CONFIG_OUTINIT_Pos);
+        }
+        s_marco_num = num;
+    }
+
+    hal_gpio_marco_cancelar();
+    for (uint8_t i = 0; i < num; i++) {
+        uint8_t canal = GPIOTE_CANAL_LEDS + i;
+        uint32_t tarea = ((niveles >> i) & 1u) ? (uint32_t)&NRF_GPIOTE->TASKS_SET[canal]
+                                                : (uint32_t)&NRF_GPIOTE->TASKS_CLR[canal];
+        uint8_t ppi = PPI_CANAL_LEDS + (i >> 1);
+        if ((i & 1u) == 0) {
+            NRF_PPI->CH[ppi].EEP = evento;
+            NRF_PPI->CH[ppi].TEP = tarea;
+            NRF_PPI->FORK[ppi].TEP = 0;
+        } else {
+            NRF_PPI->FORK[ppi].TEP = tarea;
+        }
+    }
+    NRF_PPI->CHENSET = ((1u << ((num + 1) / 2)) - 1u) << PPI_CANAL_LEDS;
+    return true;
+}
+
+void hal_gpio_marco_cancelar(void){
+    NRF_PPI->CHENCLR = ((1u << MARCO_CANALES_PPI) - 1u) << PPI_CANAL_LEDS;
 }
@@ -6,6 +6,8 @@
  * ****************************************************************************/
 
 #include "hal_sonido.h"
+#include <stddef.h>
+#include "hal_tiempo.h"
 #include "board.h"
 #include "nrf.h"
 
@@ -13,8 +15,93 @@
 // Debe estar en RAM retenida (static) para que el DMA del PWM acceda a él
 static uint16_t seq_values[1]; 
 
+/* --- Secuenciador de notas (EasyDMA) ---
+ * DECODER WaveForm: cada elemento es {COMPARE0..2, COUNTERTOP}, así que una sola
+ * palabra de RAM fija frecuencia y ciclo de una nota, y SEQ[n].REFRESH cuántos
+ * periodos dura. SEQ[0] y SEQ[1] llevan una nota cada uno y se alternan (LOOP):
+ * cuando arranca una (SEQSTARTED) la otra ya ha terminado y la IRQ le carga la
+ * nota siguiente; tiene toda la nota en curso para hacerlo.
+ * La CPU solo interviene una vez por nota, nunca en el tiempo de cada periodo. */
+#define PWM_TOP_MAX        0x7FFFu    // COUNTERTOP es de 15 bits: ~31 Hz mínimo a 1 MHz
+#define PWM_TOP_MIN        3u
+#define PWM_TOP_SILENCIO   1000u      // 1 ms por periodo en los silencios
+#define PWM_REFRESH_MAX    0xFFFFFFu
+
+static uint16_t s_onda[2][4];                     // elemento de SEQ[0] y de SEQ[1]
+static const hal_sonido_nota_t *s_notas;
+static uint8_t s_num_notas;
+static uint8_t s_siguiente;                        // próxima nota a cargar
+static bool s_primer_arranque;                     // el primer SEQSTARTED[0] no libera SEQ[1]
+static void (*s_fin_cb)(void);
+static volatile bool s_en_secuencia = false;       // STOPPED es fin de secuencia (no de tono)
+static volatile bool s_pwm_activo = false;
+static volatile bool s_en_tono = false;            // tono sonando: se cambia sin parar
+
+/* Relevo: lo que sustituye al sonido en marcha arranca en su STOPPED (pwm_relevar) */
+static void (*volatile s_arrancar)(void) = NULL;
+static uint32_t s_tono_periodo_us;
+
+/* --- PCM (EasyDMA con doble buffer) ---
+ * PWM a 16 MHz con COUNTERTOP 256: portadora de 62,5 kHz, muy por encima de lo audible,
+ * y cada muestra de 8 bits es directamente el valor de comparación. REFRESH 3 repite
+ * cada muestra 4 periodos: 15625 muestras/s. SEQ[0] y SEQ[1] apuntan a dos bloques y
+ * se encadenan sin fin (LOOPSDONE -> SEQSTART0); al SEQEND de uno (el DMA ya lo ha
+ * leído entero) la IRQ lo rellena mientras suena el otro: una IRQ cada 8,2 ms. */
+#define PCM_TOP            256u
+#define PCM_REFRESH        3u
+#define PCM_MUESTREO_HZ    (16000000u / PCM_TOP / (PCM_REFRESH + 1u))
+
+static uint16_t s_pcm[2][HAL_SONIDO_PCM_BLOQUE];
+static bool (*s_pcm_rellenar)(uint16_t *bloque, uint32_t n);
+static volatile bool s_en_pcm = false;
+static volatile int8_t s_pcm_ultimo = -1;         // bloque final ya rellenado (-1: ninguno)
+
+/* --- Click del metrónomo ---
+ * Una nota WaveForm en SEQ[0] con SEQEND0 -> STOP, y el evento de disparo de hal_tiempo
+ * unido por PPI a SEQSTART[0]: suena en el instante del comparador, sin IRQ previa.
+ * Otro sonido que ocupe el PWM antes de ese instante lo deja pendiente: al pararse
+ * se vuelve a enlazar si el comparador aún no ha saltado. */
+static volatile bool s_click_armado = false;
+static volatile bool s_click_pendiente = false;
+static hal_sonido_nota_t s_click;
+static uint8_t s_click_disparo;
+
+static void cargar_nota(uint8_t seq, const hal_sonido_nota_t *nota);
+
+// Quita el enlace PPI; si el click ya había arrancado, queda esperando su STOPPED
+static void click_desarmar(void) {
+    if (!s_click_armado) return;
+    NRF_PPI->CHENCLR = (1u << PPI_CANAL_METRONOMO);
+    s_click_armado = false;
+    if (NRF_PWM0->EVENTS_SEQSTARTED[0]) s_pwm_activo = true;
+}
+
+// Carga s_click y lo une al disparo (PWM parado)
+static void click_enlazar(void) {
+    s_en_secuencia = false;
+    s_en_pcm = false;
+    NRF_PWM0->PRESCALER = (PWM_PRESCALER_PRESCALER_DIV_16 << PWM_PRESCALER_PRESCALER_Pos);
+    NRF_PWM0->DECODER = (PWM_DECODER_LOAD_WaveForm << PWM_DECODER_LOAD_Pos) |
+                        (PWM_DECODER_MODE_RefreshCount << PWM_DECODER_MODE_Pos);
+    cargar_nota(0, &s_click);
+    NRF_PWM0->LOOP = PWM_LOOP_CNT_Disabled;
+    NRF_PWM0->SHORTS = PWM_SHORTS_SEQEND0_STOP_Msk;
+    NRF_PWM0->EVENTS_SEQSTARTED[0] = 0;
+
+    NRF_PPI->CH[PPI_CANAL_METRONOMO].EEP = hal_tiempo_disparo_evento(s_click_disparo);
+    NRF_PPI->CH[PPI_CANAL_METRONOMO].TEP = (uint32_t)&NRF_PWM0->TASKS_SEQSTART[0];
+    s_click_pendiente = false;
+    s_click_armado = true;
+    NRF_PPI->CHENSET = (1u << PPI_CANAL_METRONOMO);
+}
+
+// El PWM ha quedado libre: el click pendiente vuelve si su instante no ha pasado
+static void click_reanudar(void) {
+    if (!s_click_pendiente) return;
+    s_click_pendiente = false;
+    if (!hal_tiempo_disparo_saltado(s_click_disparo)) click_enlazar();
+}
 
-void nrf_delay_ms(uint32_t ms);
 
 void hal_sonido_iniciar(void) {
     // 1. Configurar el pin como salida
@@ -40,18 +127,213 @@ void hal_sonido_iniciar(void) {
                         
     // Habilitar el periférico PWM
     NRF_PWM0->ENABLE = 1;
+
+    // Fin de parada (tonos y secuencias) y arranque de cada mitad de la secuencia doble
+    NRF_PWM0->INTENSET = PWM_INTENSET_STOPPED_Msk | PWM_INTENSET_SEQSTARTED0_Msk |
+                         PWM_INTENSET_SEQSTARTED1_Msk | PWM_INTENSET_SEQEND0_Msk |
+                         PWM_INTENSET_SEQEND1_Msk;
+    NVIC_ClearPendingIRQ(PWM0_IRQn);
+    NVIC_EnableIRQ(PWM0_IRQn);
 }
 
-void hal_sonido_tocar(uint32_t frecuencia_hz, uint32_t duracion_ms) {
-    if (frecuencia_hz == 0) {
+/* Arranca con el PWM parado, sin eventos atrasados del sonido anterior que la IRQ
+ * pudiera tomar por los del nuevo (arrancar NULL: solo queda parado) */
+static void pwm_arrancar(void (*arrancar)(void)) {
+    NRF_PWM0->EVENTS_STOPPED = 0;
+    NRF_PWM0->EVENTS_SEQSTARTED[0] = 0;
+    NRF_PWM0->EVENTS_SEQSTARTED[1] = 0;
+    NRF_PWM0->EVENTS_SEQEND[0] = 0;
+    NRF_PWM0->EVENTS_SEQEND[1] = 0;
+    NVIC_ClearPendingIRQ(PWM0_IRQn);
+    if (arrancar != NULL) arrancar();
+}
+
+/* Sustituye lo que suena por 'arrancar' sin esperar en el llamante. STOP no es
+ * inmediato (acaba el periodo en curso: hasta ~32 ms en las notas más graves), así
+ * que con el PWM en marcha se pide y 'arrancar' corre en la IRQ de su STOPPED.
+ * Desde aquí el sonido anterior ya no avisa de su fin.
+ * Llamar con PWM0_IRQn deshabilitada (junto con lo que lee 'arrancar'). */
+static void pwm_relevar(void (*arrancar)(void)) {
+    s_en_secuencia = false;
+    s_en_pcm = false;
+    s_en_tono = false;
+    // Lo que viene ocupa el PWM: un click aún sin arrancar espera a que acabe
+    if (s_click_armado && !NRF_PWM0->EVENTS_SEQSTARTED[0]) s_click_pendiente = true;
+    click_desarmar();
+    if (s_pwm_activo) {
+        s_arrancar = arrancar;
         NRF_PWM0->TASKS_STOP = 1;
+    } else {
+        s_arrancar = NULL;
+        pwm_arrancar(arrancar);
+    }
+}
+
+/* Carga una nota en el elemento/secuencia 'seq' (0 o 1). NULL = relleno mínimo y mudo */
+static void cargar_nota(uint8_t seq, const hal_sonido_nota_t *nota) {
+    uint32_t top, comparacion, periodos;
+
+    if (nota == NULL || nota->frecuencia_hz == 0) {
+        top = PWM_TOP_SILENCIO;
+        comparacion = 0;    // sin flancos: salida fija, el buzzer calla
+        periodos = (nota == NULL) ? 1 : ((uint32_t)nota->duracion_ms * 1000u) / top;
+    } else {
+        top = 1000000u / nota->frecuencia_hz;
+        if (top > PWM_TOP_MAX) top = PWM_TOP_MAX;
+        if (top < PWM_TOP_MIN) top = PWM_TOP_MIN;
+        uint32_t pct = (nota->ciclo_pct == 0 || nota->ciclo_pct > 99) ? 50 : nota->ciclo_pct;
+        comparacion = (top * pct) / 100u;
+        periodos = ((uint32_t)nota->duracion_ms * 1000u) / top;
+    }
+    if (periodos == 0) periodos = 1;
+    if (periodos - 1 > PWM_REFRESH_MAX) periodos = PWM_REFRESH_MAX + 1;
+
+    s_onda[seq][0] = (uint16_t)comparacion;
+    s_onda[seq][1] = 0;
+    s_onda[seq][2] = 0;
+    s_onda[seq][3] = (uint16_t)top;
+    NRF_PWM0->SEQ[seq].PTR = (uint32_t)s_onda[seq];
+    NRF_PWM0->SEQ[seq].CNT = 4;                    // un elemento WaveForm
+    NRF_PWM0->SEQ[seq].REFRESH = periodos - 1;     // se repite periodos veces
+    NRF_PWM0->SEQ[seq].ENDDELAY = 0;
+}
+
+/* Siguiente nota para la secuencia 'seq', o relleno si ya no quedan */
+static void cargar_siguiente(uint8_t seq) {
+    if (s_siguiente < s_num_notas) cargar_nota(seq, &s_notas[s_siguiente++]);
+    else cargar_nota(seq, NULL);
+}
+
+static void secuencia_arrancar(void) {
+    s_siguiente = 0;
+    NRF_PWM0->PRESCALER = (PWM_PRESCALER_PRESCALER_DIV_16 << PWM_PRESCALER_PRESCALER_Pos);
+    NRF_PWM0->DECODER = (PWM_DECODER_LOAD_WaveForm << PWM_DECODER_LOAD_Pos) |
+                        (PWM_DECODER_MODE_RefreshCount << PWM_DECODER_MODE_Pos);
+    cargar_siguiente(0);
+    if (s_num_notas == 1) {
+        // Solo SEQ[0]: se para al acabarla
+        NRF_PWM0->LOOP = PWM_LOOP_CNT_Disabled;
+        NRF_PWM0->SHORTS = PWM_SHORTS_SEQEND0_STOP_Msk;
+    } else {
+        // Pares SEQ[0]+SEQ[1]; con un número impar la última SEQ[1] es el relleno mudo
+        cargar_siguiente(1);
+        NRF_PWM0->LOOP = (s_num_notas + 1u) / 2u;
+        NRF_PWM0->SHORTS = PWM_SHORTS_LOOPSDONE_STOP_Msk;
+    }
+
+    s_primer_arranque = true;
+    s_en_secuencia = true;
+    s_pwm_activo = true;
+    NRF_PWM0->TASKS_SEQSTART[0] = 1;
+}
+
+bool hal_sonido_secuencia(const hal_sonido_nota_t *notas, uint8_t num_notas, void (*fin_cb)(void)) {
+    NVIC_DisableIRQ(PWM0_IRQn);
+    if (notas == NULL || num_notas == 0) {
+        pwm_relevar(NULL);
+    } else {
+        s_notas = notas;
+        s_num_notas = num_notas;
+        s_fin_cb = fin_cb;
+        pwm_relevar(secuencia_arrancar);
+    }
+    NVIC_EnableIRQ(PWM0_IRQn);
+    return true;
+}
+
+static void pcm_arrancar(void) {
+    s_pcm_ultimo = -1;
+    NRF_PWM0->PRESCALER = (PWM_PRESCALER_PRESCALER_DIV_1 << PWM_PRESCALER_PRESCALER_Pos);
+    NRF_PWM0->COUNTERTOP = PCM_TOP;
+    NRF_PWM0->DECODER = (PWM_DECODER_LOAD_Common << PWM_DECODER_LOAD_Pos) |
+                        (PWM_DECODER_MODE_RefreshCount << PWM_DECODER_MODE_Pos);
+    for (uint8_t seq = 0; seq < 2; seq++) {
+        if (s_pcm_ultimo >= 0) {
+            for (uint32_t i = 0; i < HAL_SONIDO_PCM_BLOQUE; i++) s_pcm[seq][i] = HAL_SONIDO_PCM_MAX / 2u;
+        } else if (!s_pcm_rellenar(s_pcm[seq], HAL_SONIDO_PCM_BLOQUE)) {
+            s_pcm_ultimo = (int8_t)seq;
+        }
+        NRF_PWM0->SEQ[seq].PTR = (uint32_t)s_pcm[seq];
+        NRF_PWM0->SEQ[seq].CNT = HAL_SONIDO_PCM_BLOQUE;
+        NRF_PWM0->SEQ[seq].REFRESH = PCM_REFRESH;
+        NRF_PWM0->SEQ[seq].ENDDELAY = 0;
+    }
+    NRF_PWM0->LOOP = 1;                                      // SEQ[0]+SEQ[1] ...
+    NRF_PWM0->SHORTS = PWM_SHORTS_LOOPSDONE_SEQSTART0_Msk;   // ... y vuelta a empezar
+
+    s_en_pcm = true;
+    s_pwm_activo = true;
+    NRF_PWM0->TASKS_SEQSTART[0] = 1;
+}
+
+uint32_t hal_sonido_pcm(bool (*rellenar)(uint16_t *bloque, uint32_t n)) {
+    if (rellenar == NULL) return PCM_MUESTREO_HZ;   // solo consulta
+
+    NVIC_DisableIRQ(PWM0_IRQn);
+    s_pcm_rellenar = rellenar;
+    pwm_relevar(pcm_arrancar);
+    NVIC_EnableIRQ(PWM0_IRQn);
+    return PCM_MUESTREO_HZ;
+}
+
+/* Bloque 'seq' leído por el DMA: se rellena, o se para si era el último */
+static void pcm_bloque_leido(uint8_t seq) {
+    if (s_pcm_ultimo >= 0) {
+        // El último bloque ya está en su última muestra: STOP la corta al acabar el periodo
+        if (s_pcm_ultimo == (int8_t)seq) NRF_PWM0->TASKS_STOP = 1;
         return;
     }
+    if (!s_pcm_rellenar(s_pcm[seq], HAL_SONIDO_PCM_BLOQUE)) s_pcm_ultimo = (int8_t)seq;
+}
+
+void PWM0_IRQHandler(void) {
+    for (uint8_t seq = 0; seq < 2; seq++) {
+        if (NRF_PWM0->EVENTS_SEQEND[seq]) {
+            NRF_PWM0->EVENTS_SEQEND[seq] = 0;
+            if (s_en_pcm) pcm_bloque_leido(seq);
+        }
+    }
+    if (NRF_PWM0->EVENTS_SEQSTARTED[1]) {
+        NRF_PWM0->EVENTS_SEQSTARTED[1] = 0;
+        if (s_en_secuencia) cargar_siguiente(0);
+    }
+    if (NRF_PWM0->EVENTS_SEQSTARTED[0]) {
+        NRF_PWM0->EVENTS_SEQSTARTED[0] = 0;
+        if (s_click_armado) {
+            click_desarmar();       // un armado, un click (el comparador vuelve a coincidir cada vuelta)
+            s_pwm_activo = true;
+        }
+        else if (s_primer_arranque) s_primer_arranque = false;
+        else if (s_en_secuencia) cargar_siguiente(1);
+    }
+    if (NRF_PWM0->EVENTS_STOPPED) {
+        NRF_PWM0->EVENTS_STOPPED = 0;
+        s_pwm_activo = false;
+        s_en_pcm = false;
+        s_en_tono = false;
+        if (s_en_secuencia) {
+            s_en_secuencia = false;
+            if (s_fin_cb) s_fin_cb();
+        }
+        if (s_arrancar != NULL) {              // relevo pedido por pwm_relevar
+            void (*arrancar)(void) = s_arrancar;
+            s_arrancar = NULL;
+            pwm_arrancar(arrancar);
+        }
+        if (!s_pwm_activo) click_reanudar();   // salvo que haya arrancado otro sonido
+    }
+}
+
+// Tono en s_tono_periodo_us; sobre otro tono basta con cambiar el periodo
+static void tono_arrancar(void) {
+    uint32_t periodo_us = s_tono_periodo_us;
+
+    NRF_PWM0->PRESCALER = (PWM_PRESCALER_PRESCALER_DIV_16 << PWM_PRESCALER_PRESCALER_Pos);
+    NRF_PWM0->DECODER = (PWM_DECODER_LOAD_Common << PWM_DECODER_LOAD_Pos) |
+                        (PWM_DECODER_MODE_RefreshCount << PWM_DECODER_MODE_Pos);
+    NRF_PWM0->LOOP = PWM_LOOP_CNT_Disabled;
+    NRF_PWM0->SHORTS = 0;
 
-    // Calcular el periodo en microsegundos (T = 1/f)
-    // Con el reloj a 1MHz, el valor del contador equivale a us.
-    uint32_t periodo_us = 1000000 / frecuencia_hz;
-    
     // El "Top Value" del contador determina la frecuencia de la onda
     NRF_PWM0->COUNTERTOP = periodo_us;
     
@@ -65,20 +347,62 @@ void hal_sonido_tocar(uint32_t frecuencia_hz, uint32_t duracion_ms) {
     NRF_PWM0->SEQ[0].REFRESH = 0;
     NRF_PWM0->SEQ[0].ENDDELAY = 0;
     
-    // Disparar la tarea de inicio de secuencia
+    // Disparar la tarea de inicio de secuencia: el PWM mantiene el último
+    // valor al acabar, así que la nota suena hasta hal_sonido_parar.
+    // La duración la controla el driver con un canal de drv_tiempo (sin esperas aquí).
+    s_en_tono = true;
+    s_pwm_activo = true;
     NRF_PWM0->TASKS_SEQSTART[0] = 1;
-    
-    // Espera "sucia" para mantener la nota (bloqueante simple para esta práctica)
-    // En un sistema real usaríamos alarmas para apagarlo asíncronamente.
-    nrf_delay_ms(duracion_ms);
-    
-    // Apagar sonido al terminar el tiempo
+}
+
+void hal_sonido_iniciar_tono(uint32_t frecuencia_hz) {
+    if (frecuencia_hz == 0) {
+        hal_sonido_parar();
+        return;
+    }
+
+    NVIC_DisableIRQ(PWM0_IRQn);
+    // Calcular el periodo en microsegundos (T = 1/f)
+    // Con el reloj a 1MHz, el valor del contador equivale a us.
+    s_tono_periodo_us = 1000000 / frecuencia_hz;
+    // Sobre otro tono se cambia en marcha. Si venía de una secuencia, de PCM, del click
+    // o de una parada aún sin acabar, vuelta al modo de un solo valor con el PWM parado
+    if (s_en_tono) tono_arrancar();
+    else pwm_relevar(tono_arrancar);
+    NVIC_EnableIRQ(PWM0_IRQn);
+}
+
+void hal_sonido_parar(void) {
+    s_arrancar = NULL;          // un relevo pendiente tampoco arranca
+    s_en_secuencia = false;     // parada pedida: no es fin de secuencia
+    s_en_pcm = false;
+    s_en_tono = false;
+    click_desarmar();
     NRF_PWM0->TASKS_STOP = 1;
 }
 
-// Función auxiliar simple para delay (si no tienes nrf_delay.h incluido)
-void nrf_delay_ms(uint32_t ms) {
-    // Aproximación para bucle en C con optimización baja/media a 64MHz
-    volatile uint32_t i = ms * 6000; 
-    while(i--) __NOP();
+bool hal_sonido_activo(void) {
+    return s_pwm_activo;
+}
+
+void hal_sonido_click_cancelar(void) {
+    NVIC_DisableIRQ(PWM0_IRQn);         // STOPPED no puede re-enlazarlo a medias
+    click_desarmar();
+    s_click_pendiente = false;
+    NVIC_EnableIRQ(PWM0_IRQn);
+}
+
+bool hal_sonido_click_armar(uint8_t disparo, uint32_t frecuencia_hz, uint32_t duracion_ms) {
+    if (hal_tiempo_disparo_evento(disparo) == 0 || frecuencia_hz == 0) return false;
+
+    NVIC_DisableIRQ(PWM0_IRQn);
+    s_click_disparo = disparo;
+    s_click.frecuencia_hz = (uint16_t)frecuencia_hz;
+    s_click.duracion_ms = (uint16_t)duracion_ms;
+    s_click.ciclo_pct = 50;
+    // Sonando otra cosa: se enlaza en su STOPPED (click_reanudar)
+    if (s_pwm_activo) s_click_pendiente = true;
+    else click_enlazar();
+    NVIC_EnableIRQ(PWM0_IRQn);
+    return true;
 }
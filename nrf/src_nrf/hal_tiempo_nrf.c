@@ -4,6 +4,8 @@
  */
  #include <nrf.h>
 #include "hal_tiempo.h"
+#include "hal_SC.h"
+#include "board.h"
 #include <stdlib.h>
 
 
@@ -12,15 +14,432 @@
 #define COUNTER_BITS      32u
 #define COUNTER_MAX       (0xFFFFFFFFu)
 
+/* ---- Captura de flancos: TIMER4 CC[0..3] disparados por PPI --------------- */
+/* TIMER4 cuenta a 16 MHz con el mismo HFCLK que TIMER1, asi que su desfase es
+ * constante: se fija una vez arrancando TIMER4 en el ciclo en que se captura TIMER1
+ * (EGU0 -> PPI -> CAPTURE en TIMER1 CC[3] y, por el FORK, START de TIMER4). Asi no
+ * gasta ningun CC de TIMER4: CC[4] y CC[5] quedan para los disparos. */
+static const uint8_t k_cc_disparo[HAL_TIEMPO_DISPAROS] = { 5, 4 };
+#define DISPARO_MARGEN    16u    /* 1 us: un CC demasiado cerca puede no saltar */
+
+static volatile bool s_captura_activa = false;
+static uint32_t s_desfase_captura = 0;   /* TIMER1 - TIMER4 */
+static uint64_t s_base_captura = 0;      /* tick en el que TIMER1 valia 0 */
+
+/* ---- Contador de ciclos: DWT->CYCCNT (se habilita aunque no haya depurador) */
+static void ciclos_iniciar(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/* Llamar con TIMER1 ya contando; base = tick correspondiente a TIMER1 = 0 */
+static void captura_sincronizar(uint64_t base) {
+    NRF_TIMER4->TASKS_STOP = 1;
+    NRF_TIMER4->TASKS_CLEAR = 1;
+    NRF_TIMER4->MODE = TIMER_MODE_MODE_Timer;
+    NRF_TIMER4->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+    NRF_TIMER4->PRESCALER = 0;
+    NRF_TIMER4->SHORTS = 0;
+    /* Disparos de antes del reinicio: que no salten al pasar la cuenta por ellos */
+    for (uint8_t n = 0; n < HAL_TIEMPO_DISPAROS; n++) {
+        NRF_TIMER4->CC[k_cc_disparo[n]] = COUNTER_MAX;
+        NRF_TIMER4->EVENTS_COMPARE[k_cc_disparo[n]] = 0;
+    }
+
+    NRF_PPI->CH[PPI_CANAL_SYNC_CAPTURA].EEP = (uint32_t)&NRF_EGU0->EVENTS_TRIGGERED[0];
+    NRF_PPI->CH[PPI_CANAL_SYNC_CAPTURA].TEP = (uint32_t)&NRF_TIMER1->TASKS_CAPTURE[3];
+    NRF_PPI->FORK[PPI_CANAL_SYNC_CAPTURA].TEP = (uint32_t)&NRF_TIMER4->TASKS_START;
+    NRF_PPI->CHENSET = (1u << PPI_CANAL_SYNC_CAPTURA);
+
+    NRF_EGU0->EVENTS_TRIGGERED[0] = 0;
+    NRF_EGU0->TASKS_TRIGGER[0] = 1;
+    while (NRF_EGU0->EVENTS_TRIGGERED[0] == 0) {}
+    NRF_EGU0->EVENTS_TRIGGERED[0] = 0;
+    NRF_PPI->CHENCLR = (1u << PPI_CANAL_SYNC_CAPTURA);
+
+    s_desfase_captura = NRF_TIMER1->CC[3];      /* TIMER4 valia 0 en ese ciclo */
+    s_base_captura = base;
+    s_captura_activa = true;
+}
+
+static void captura_parar(void) {
+    s_captura_activa = false;
+    NRF_TIMER4->TASKS_STOP = 1;
+}
+
+/* ---- Prioridades --------------------------------------------------------- */
+/* Las ISR de la base de tiempo solo cuentan desbordes y van en HAL_SC_PRIORIDAD_CRITICA:
+ * una seccion critica (BASEPRI) no las retrasa. El callback de la alarma si entra en el
+ * runtime: se difiere a IRQ_ALARMA (SWI1, sin evento de EGU), a la prioridad del runtime */
+#define IRQ_ALARMA        SWI1_EGU1_IRQn
+
+static void alarma_comprobar(void);
+
+void SWI1_EGU1_IRQHandler(void) __irq {
+    alarma_comprobar();
+}
+
+static void prioridades_iniciar(IRQn_Type irq_base) {
+    NVIC_SetPriority(irq_base, HAL_SC_PRIORIDAD_CRITICA);
+    NVIC_SetPriority(IRQ_ALARMA, HAL_SC_PRIORIDAD_RUNTIME);
+    NVIC_ClearPendingIRQ(IRQ_ALARMA);
+    NVIC_EnableIRQ(IRQ_ALARMA);
+}
+
+#if defined(HAL_TIEMPO_RTC)
+/* *****************************************************************************
+ * Base de tiempo de bajo consumo: RTC1 a 32768 Hz (LFCLK), HFCLK apagado en reposo.
+ * Se siguen entregando ticks "virtuales" de 16 MHz (ticks_per_us = 16) para que
+ * drv_tiempo no cambie: tick = cuenta_rtc * 15625 / 32  (= 16e6 / 32768).
+ * Resolucion en reposo: 30.5 us. hal_tiempo_alta_resolucion(true) enciende HFCLK
+ * y TIMER1 anclado a un flanco del RTC; mientras dure, la lectura es de 1/16 us.
+ */
+#define RTC_MASCARA        0x00FFFFFFu  /* contador de 24 bits */
+#define RTC_MARGEN_CC      2u           /* un CC a menos de 2 cuentas puede no disparar */
+
+static void canales_iniciar(void);
+
+/* ---- Tick libre con RTC1 (+ TIMER1 en alta resolucion) --------------------- */
+static volatile uint32_t s_overflows_rtc = 0;
+static volatile uint32_t s_overflows_t1 = 0;
+static volatile bool s_alta = false;            /* TIMER1 encendido y en uso */
+static volatile uint64_t s_base_alta = 0;       /* tick del flanco RTC que arranco TIMER1 */
+static volatile uint64_t s_ajuste = 0;          /* desplazamiento del RTC para no ir hacia atras */
+
+/* ---- Alarma one-shot: RTC1 CC[0] (o TIMER1 CC[2] en alta resolucion) ------- */
+static void (* volatile s_cb_alarma)() = 0;
+static volatile uint64_t s_alarma_tick = 0;
+
+/* Cuenta de 64 bits del RTC; valida tambien con IRQs deshabilitadas */
+static uint64_t rtc_cuenta64(void) {
+    uint32_t hi, lo, pendiente;
+    do {
+        hi = s_overflows_rtc;
+        lo = NRF_RTC1->COUNTER;
+        pendiente = NRF_RTC1->EVENTS_OVRFLW;
+    } while (hi != s_overflows_rtc);
+    if (pendiente) {                 /* desborde aun no atendido por la ISR */
+        hi++;
+        lo = NRF_RTC1->COUNTER;
+    }
+    return ((uint64_t)hi << 24) | lo;
+}
+
+static inline uint64_t rtc_a_tick(uint64_t cuenta) {
+    return ((cuenta * 15625u) >> 5) + s_ajuste;
+}
+
+/* Primera cuenta del RTC cuyo tick es >= t */
+static uint64_t tick_a_rtc_techo(uint64_t t) {
+    if (t <= s_ajuste) return 0;
+    return ((t - s_ajuste) * 32u + 15624u) / 15625u;
+}
+
+static uint64_t timer1_tick64(void) {
+    uint32_t hi1, lo1, lo2;
+
+    NRF_TIMER1->TASKS_CAPTURE[1] = 1;
+    lo1 = NRF_TIMER1->CC[1];
+    hi1 = s_overflows_t1;
+    NRF_TIMER1->TASKS_CAPTURE[1] = 1;
+    lo2 = NRF_TIMER1->CC[1];
+    if (lo2 < lo1) hi1 = s_overflows_t1;
+    return (((uint64_t)hi1) * ((uint64_t)(COUNTER_MAX + 1u))) + lo2;
+}
+
+static void alarma_armar(void);
+
+/* Desde IRQ_ALARMA: dispara la alarma si ya ha llegado su instante */
+static void alarma_comprobar(void) {
+    if (s_cb_alarma == 0) return;
+    if (hal_tiempo_actual_tick64() >= s_alarma_tick) {
+        void (*cb)() = s_cb_alarma;
+        s_cb_alarma = 0;
+        NRF_RTC1->INTENCLR = RTC_INTENCLR_COMPARE0_Msk;
+        NRF_TIMER1->INTENCLR = TIMER_INTENCLR_COMPARE2_Msk;
+        cb();
+    } else {
+        alarma_armar();              /* coincidencia de 24/32 bits de otra vuelta */
+    }
+}
+
+void RTC1_IRQHandler(void) __irq {
+    if (NRF_RTC1->EVENTS_OVRFLW) {
+        NRF_RTC1->EVENTS_OVRFLW = 0;
+        s_overflows_rtc++;
+    }
+    if (NRF_RTC1->EVENTS_COMPARE[0]) {
+        NRF_RTC1->EVENTS_COMPARE[0] = 0;
+        NVIC_SetPendingIRQ(IRQ_ALARMA);
+    }
+}
+
+void TIMER1_IRQHandler(void) __irq {
+    if (NRF_TIMER1->EVENTS_COMPARE[0]) {
+        NRF_TIMER1->EVENTS_COMPARE[0] = 0;
+        s_overflows_t1++;
+    }
+    if (NRF_TIMER1->EVENTS_COMPARE[2]) {
+        NRF_TIMER1->EVENTS_COMPARE[2] = 0;
+        NVIC_SetPendingIRQ(IRQ_ALARMA);
+    }
+}
+
+void hal_tiempo_iniciar_tick(hal_tiempo_info_t *out_info) {
+    ciclos_iniciar();
+    /* LFCLK del cristal: es lo unico que queda encendido en reposo */
+    NRF_CLOCK->LFCLKSRC = (CLOCK_LFCLKSRC_SRC_Xtal << CLOCK_LFCLKSRC_SRC_Pos);
+    NRF_CLOCK->EVENTS_LFCLKSTARTED = 0;
+    NRF_CLOCK->TASKS_LFCLKSTART = 1;
+    while (NRF_CLOCK->EVENTS_LFCLKSTARTED == 0) {}
+
+    NRF_RTC1->TASKS_STOP = 1;
+    NRF_RTC1->TASKS_CLEAR = 1;
+    NRF_RTC1->PRESCALER = 0;                            /* 32768 Hz */
+    NRF_RTC1->EVENTS_OVRFLW = 0;
+    NRF_RTC1->INTENSET = RTC_INTENSET_OVRFLW_Msk;
+    s_overflows_rtc = 0;
+    s_ajuste = 0;
+    s_alta = false;
+
+    prioridades_iniciar(RTC1_IRQn);
+    NVIC_SetPriority(TIMER1_IRQn, HAL_SC_PRIORIDAD_CRITICA);
+    NVIC_EnableIRQ(RTC1_IRQn);
+    NVIC_EnableIRQ(TIMER1_IRQn);                        /* solo interrumpe en alta resolucion */
+    NRF_RTC1->TASKS_START = 1;
+    canales_iniciar();
+
+    out_info->ticks_per_us   = TICKS_PER_US;
+    out_info->counter_bits   = COUNTER_BITS;
+    out_info->counter_max    = COUNTER_MAX;
+}
+
+uint64_t hal_tiempo_actual_tick64(void) {
+    if (s_alta) {
+        return s_base_alta + timer1_tick64();
+    }
+    return rtc_a_tick(rtc_cuenta64());
+}
+
+/* Llamar con IRQ_ALARMA bloqueada (seccion critica o desde su ISR) */
+static void alarma_armar(void) {
+    if (s_alta) {
+        NRF_RTC1->INTENCLR = RTC_INTENCLR_COMPARE0_Msk;
+        NRF_TIMER1->CC[2] = (uint32_t)(s_alarma_tick - s_base_alta);
+        NRF_TIMER1->EVENTS_COMPARE[2] = 0;
+        NRF_TIMER1->INTENSET = TIMER_INTENSET_COMPARE2_Msk;
+        if (hal_tiempo_actual_tick64() >= s_alarma_tick) {
+            NVIC_SetPendingIRQ(IRQ_ALARMA);
+        }
+    } else {
+        /* Redondeo hacia arriba: nunca antes de tiempo, como mucho 30.5 us tarde */
+        uint64_t objetivo = tick_a_rtc_techo(s_alarma_tick);
+        uint64_t minimo = rtc_cuenta64() + RTC_MARGEN_CC;
+        if (objetivo < minimo) objetivo = minimo;
+
+        NRF_TIMER1->INTENCLR = TIMER_INTENCLR_COMPARE2_Msk;
+        NRF_RTC1->CC[0] = (uint32_t)objetivo & RTC_MASCARA;
+        NRF_RTC1->EVENTS_COMPARE[0] = 0;
+        NRF_RTC1->INTENSET = RTC_INTENSET_COMPARE0_Msk;
+    }
+}
+
+void hal_tiempo_alarma_tick(uint64_t deadline_tick, void (*funcion_callback_drv)()) {
+    hal_tiempo_alarma_cancelar();
+    if (funcion_callback_drv == NULL) return;
+
+    s_alarma_tick = deadline_tick;
+    s_cb_alarma = funcion_callback_drv;
+    alarma_armar();
+}
+
+void hal_tiempo_alarma_cancelar(void) {
+    NRF_RTC1->INTENCLR = RTC_INTENCLR_COMPARE0_Msk;
+    NRF_TIMER1->INTENCLR = TIMER_INTENCLR_COMPARE2_Msk;
+    s_cb_alarma = 0;
+    NRF_RTC1->EVENTS_COMPARE[0] = 0;
+    NRF_TIMER1->EVENTS_COMPARE[2] = 0;
+}
+
+/* Arrancar el HFXO es lo lento (~360 us): va aparte para esperarlo fuera de la
+ * seccion critica del cambio de reloj */
+void hal_tiempo_reloj_rapido(bool encender) {
+    if (encender) {
+        NRF_CLOCK->EVENTS_HFCLKSTARTED = 0;
+        NRF_CLOCK->TASKS_HFCLKSTART = 1;
+        while (NRF_CLOCK->EVENTS_HFCLKSTARTED == 0) {}
+    } else {
+        NRF_CLOCK->TASKS_HFCLKSTOP = 1;
+    }
+}
+
+void hal_tiempo_alta_resolucion(bool activar) {
+    if (activar == s_alta) return;
+
+    if (activar) {
+        NRF_TIMER1->TASKS_STOP = 1;
+        NRF_TIMER1->TASKS_CLEAR = 1;
+        NRF_TIMER1->MODE = TIMER_MODE_MODE_Timer;
+        NRF_TIMER1->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+        NRF_TIMER1->PRESCALER = 0;                      /* 16 MHz */
+        NRF_TIMER1->CC[0] = COUNTER_MAX;
+        NRF_TIMER1->SHORTS = TIMER_SHORTS_COMPARE0_CLEAR_Msk;
+        NRF_TIMER1->EVENTS_COMPARE[0] = 0;
+        NRF_TIMER1->INTENSET = TIMER_INTENSET_COMPARE0_Msk;
+        s_overflows_t1 = 0;
+
+        /* Continuidad: TIMER1 arranca en el flanco del RTC y cuenta desde su tick */
+        uint64_t cuenta = rtc_cuenta64();
+        while (rtc_cuenta64() == cuenta) {}
+        NRF_TIMER1->TASKS_START = 1;
+        s_base_alta = rtc_a_tick(cuenta + 1u);
+        s_alta = true;
+        captura_sincronizar(s_base_alta);   /* solo hay captura con HFCLK encendido */
+    } else {
+        uint64_t fino = hal_tiempo_actual_tick64();
+        captura_parar();
+        s_alta = false;
+        NRF_TIMER1->INTENCLR = TIMER_INTENCLR_COMPARE0_Msk | TIMER_INTENCLR_COMPARE2_Msk;
+        NRF_TIMER1->TASKS_STOP = 1;
+
+        /* Los dos relojes derivan unos ppm: el RTC no puede quedar por detras */
+        uint64_t grueso = hal_tiempo_actual_tick64();
+        if (fino > grueso) s_ajuste += fino - grueso;
+    }
+
+    if (s_cb_alarma) alarma_armar();    /* la alarma pasa al comparador del otro reloj */
+}
+
+/* ---- Canales con RTC2 CC[0..3] ------------------------------------------- */
+/* Periodo en fraccion de cuenta (ticks*32/15625): el resto se acumula y el periodo
+ * medio es exacto aunque cada disparo caiga en una cuenta entera del RTC */
+#define CANAL_CUENTAS_MIN  3u
+
+static void (*s_cb_canal[HAL_TIEMPO_CANALES])(uint8_t canal);
+static uint64_t s_periodo_canal[HAL_TIEMPO_CANALES];   /* ticks * 32 */
+static uint32_t s_resto_canal[HAL_TIEMPO_CANALES];     /* < 15625 */
+static bool s_periodico_canal[HAL_TIEMPO_CANALES];
+static volatile uint32_t s_canales_activos = 0;
+static volatile uint32_t s_canales_forzados = 0;
+
+static void canal_programar(uint8_t canal, uint32_t desde) {
+    uint64_t total = s_periodo_canal[canal] + s_resto_canal[canal];
+    uint32_t cuentas = (uint32_t)(total / 15625u);
+    s_resto_canal[canal] = (uint32_t)(total % 15625u);
+    if (cuentas < CANAL_CUENTAS_MIN) cuentas = CANAL_CUENTAS_MIN;
+
+    NRF_RTC2->CC[canal] = (desde + cuentas) & RTC_MASCARA;
+    /* a menos de RTC_MARGEN_CC el comparador podria no disparar: se atiende ya */
+    if (((NRF_RTC2->COUNTER - desde) & RTC_MASCARA) + RTC_MARGEN_CC > cuentas) {
+        s_canales_forzados |= (1u << canal);
+        NVIC_SetPendingIRQ(RTC2_IRQn);
+    }
+}
+
+void RTC2_IRQHandler(void) __irq {
+    uint32_t vencidos = s_canales_forzados;
+    s_canales_forzados = 0;
+
+    for (uint8_t c = 0; c < HAL_TIEMPO_CANALES; c++) {
+        if (NRF_RTC2->EVENTS_COMPARE[c]) {
+            NRF_RTC2->EVENTS_COMPARE[c] = 0;
+            vencidos |= (1u << c);
+        }
+    }
+    for (uint8_t c = 0; c < HAL_TIEMPO_CANALES; c++) {
+        if ((vencidos & s_canales_activos & (1u << c)) == 0) continue;
+        if (s_periodico_canal[c]) {
+            canal_programar(c, NRF_RTC2->CC[c]);   /* desde el disparo anterior: sin deriva */
+        } else {
+            s_canales_activos &= ~(1u << c);
+            NRF_RTC2->INTENCLR = (RTC_INTENSET_COMPARE0_Msk << c);
+        }
+        if (s_cb_canal[c]) s_cb_canal[c](c);
+    }
+}
+
+static void canales_iniciar(void) {
+    NRF_RTC2->TASKS_STOP = 1;
+    NRF_RTC2->TASKS_CLEAR = 1;
+    NRF_RTC2->PRESCALER = 0;
+    s_canales_activos = 0;
+    NVIC_EnableIRQ(RTC2_IRQn);
+    NRF_RTC2->TASKS_START = 1;
+}
+
+void hal_tiempo_canal_config_tick(uint8_t canal, uint32_t periodo_en_tick, bool periodico) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    hal_tiempo_canal_enable(canal, false);
+    s_periodo_canal[canal] = (uint64_t)periodo_en_tick * 32u;
+    s_periodico_canal[canal] = periodico;
+}
+
+void hal_tiempo_canal_set_callback(uint8_t canal, void (*cb)(uint8_t canal)) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    s_cb_canal[canal] = cb;
+}
+
+void hal_tiempo_canal_enable(uint8_t canal, bool enable) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    NRF_RTC2->INTENCLR = (RTC_INTENSET_COMPARE0_Msk << canal);
+    s_canales_activos &= ~(1u << canal);
+    s_canales_forzados &= ~(1u << canal);
+    NRF_RTC2->EVENTS_COMPARE[canal] = 0;
+    if (enable && s_periodo_canal[canal] != 0) {
+        s_resto_canal[canal] = 0;
+        s_canales_activos |= (1u << canal);
+        canal_programar(canal, NRF_RTC2->COUNTER);
+        NRF_RTC2->INTENSET = (RTC_INTENSET_COMPARE0_Msk << canal);
+    }
+}
+
+/* Alarma (ya en ticks) y canales de RTC2: lo que le falta a cada CC en cuentas */
+uint64_t hal_tiempo_proximo_tick(void) {
+    uint64_t ahora = hal_tiempo_actual_tick64();
+    uint64_t proximo = s_cb_alarma ? s_alarma_tick : HAL_TIEMPO_NUNCA;
+    uint32_t cuenta = NRF_RTC2->COUNTER;
+
+    for (uint8_t c = 0; c < HAL_TIEMPO_CANALES; c++) {
+        if ((s_canales_activos & (1u << c)) == 0) continue;
+        if (s_canales_forzados & (1u << c)) return ahora;
+        uint32_t faltan = (NRF_RTC2->CC[c] - cuenta) & RTC_MASCARA;
+        uint64_t t = ahora + (((uint64_t)faltan * 15625u) >> 5);
+        if (t < proximo) proximo = t;
+    }
+    return proximo;
+}
+
+#else /* !HAL_TIEMPO_RTC: TIMER1 libre + canales en TIMER3, HFCLK siempre encendido */
+
 
 /* ---- Tick libre con T1 --------------------------------------------------- */
 static volatile uint32_t s_overflows_t1 = 0;  /* cuenta desbordes de T1 */
+static void canales_iniciar(void);
+
+/* ---- Alarma one-shot con T1 CC[2] ----------------------------------------- */
+static void (* volatile s_cb_alarma)() = 0;  /* NULL si no hay alarma armada */
+static volatile uint64_t s_alarma_tick = 0;   /* instante absoluto de disparo */
 
 void TIMER1_IRQHandler(void) __irq {
 		if( NRF_TIMER1->EVENTS_COMPARE[0]){
 			NRF_TIMER1->EVENTS_COMPARE[0] = 0; //limpio el flag que ha causado la interrupcin
 			s_overflows_t1++;
 		}
+		if( NRF_TIMER1->EVENTS_COMPARE[2]){
+			NRF_TIMER1->EVENTS_COMPARE[2] = 0; //comparador de la alarma one-shot
+			NVIC_SetPendingIRQ(IRQ_ALARMA);
+		}
+}
+
+/* Desde IRQ_ALARMA. CC[2] solo compara 32 bits: comprobamos el instante completo de 64 */
+static void alarma_comprobar(void) {
+    if (s_cb_alarma && hal_tiempo_actual_tick64() >= s_alarma_tick) {
+        void (*cb)() = s_cb_alarma;
+        s_cb_alarma = 0;
+        NRF_TIMER1->INTENCLR = TIMER_INTENCLR_COMPARE2_Msk;
+        cb();
+    }
 }
 
 /* *****************************************************************************
@@ -28,6 +447,7 @@ void TIMER1_IRQHandler(void) __irq {
  */
 void hal_tiempo_iniciar_tick(hal_tiempo_info_t *out_info) {
 
+		ciclos_iniciar();
 		NRF_TIMER1->TASKS_STOP = 1;	//Detengo el timer para que deje de contar mientas configuro
 		NRF_TIMER1->TASKS_CLEAR = 1;	//Reinicio el contador
 	
@@ -38,12 +458,15 @@ void hal_tiempo_iniciar_tick(hal_tiempo_info_t *out_info) {
 		NRF_TIMER1->CC[0] = COUNTER_MAX;	// Configuro el evento de comparacin para que salte la interrupcin cuando el counter llegue a COUNTER_MAX
 		NRF_TIMER1->INTENSET = TIMER_INTENSET_COMPARE0_Msk;	//habilito la interrupcin cuando suceda el evento
 	
+		prioridades_iniciar(TIMER1_IRQn);
 		NVIC_EnableIRQ(TIMER1_IRQn); // habilito las interrupciones del timer
 		
 		NRF_TIMER1->SHORTS = TIMER_SHORTS_COMPARE0_CLEAR_Msk;  // Reseteo el valor de los tick automtico al llegar a COUNTER_MAX
 		s_overflows_t1 = 0;//inicializo el contador de overflows a cero
 	
 		NRF_TIMER1->TASKS_START = 1; //comienzo a contar con el timer
+		canales_iniciar();
+		captura_sincronizar(0);
 	
 		out_info->ticks_per_us   = TICKS_PER_US;
     out_info->counter_bits   = COUNTER_BITS;
@@ -70,69 +493,201 @@ uint64_t hal_tiempo_actual_tick64(void) {
 
 /* ***************************************************************************** */
 
-/* ---- Reloj peridico con T0 ---------------------------------------------- */
-static void (*s_cb)() = 0;		//puntero a funcion a llamar cuando salte la RSI (en modo irq)
+/* ---- Canales con TIMER3 libre: CC[0..3] ---------------------------------- */
+/* TIMER0 solo tiene 4 CC y leer la cuenta gasta uno: TIMER3 tiene 6 y CC[5]
+ * queda para capturar el instante actual */
+#define T3_CC_CAPTURA     5
 
-/* *****************************************************************************
- * Timer Interrupt Service Routine
- * llama a la funcion de callbak que se ejecutara en modo irq
- */
+static void (*s_cb_canal[HAL_TIEMPO_CANALES])(uint8_t canal);
+static uint32_t s_periodo_canal[HAL_TIEMPO_CANALES];
+static bool s_periodico_canal[HAL_TIEMPO_CANALES];
+static volatile uint32_t s_canales_activos = 0;
+static volatile uint32_t s_canales_forzados = 0;
 
-void TIMER0_IRQHandler(void) __irq {
-    if (NRF_TIMER0->EVENTS_COMPARE[0]) {
-			NRF_TIMER0->EVENTS_COMPARE[0] = 0;	// Clear interrupt flag
-			if (s_cb) s_cb();                  // llamar callback
-			
-		}
+static inline uint32_t timer3_ahora(void) {
+    NRF_TIMER3->TASKS_CAPTURE[T3_CC_CAPTURA] = 1;
+    return NRF_TIMER3->CC[T3_CC_CAPTURA];
+}
+
+/* CC = desde + periodo; si ya se rebaso no habria comparacion hasta la siguiente vuelta */
+static void canal_programar(uint8_t canal, uint32_t desde) {
+    NRF_TIMER3->CC[canal] = desde + s_periodo_canal[canal];
+    if ((uint32_t)(timer3_ahora() - desde) >= s_periodo_canal[canal]) {
+        s_canales_forzados |= (1u << canal);
+        NVIC_SetPendingIRQ(TIMER3_IRQn);
+    }
+}
+
+void TIMER3_IRQHandler(void) __irq {
+    uint32_t vencidos = s_canales_forzados;
+    s_canales_forzados = 0;
+
+    for (uint8_t c = 0; c < HAL_TIEMPO_CANALES; c++) {
+        if (NRF_TIMER3->EVENTS_COMPARE[c]) {
+            NRF_TIMER3->EVENTS_COMPARE[c] = 0;	// Clear interrupt flag
+            vencidos |= (1u << c);
+        }
+    }
+    for (uint8_t c = 0; c < HAL_TIEMPO_CANALES; c++) {
+        if ((vencidos & s_canales_activos & (1u << c)) == 0) continue;
+        if (s_periodico_canal[c]) {
+            canal_programar(c, NRF_TIMER3->CC[c]);  /* desde la comparacion anterior: sin deriva */
+        } else {
+            s_canales_activos &= ~(1u << c);
+            NRF_TIMER3->INTENCLR = (TIMER_INTENSET_COMPARE0_Msk << c);
+        }
+        if (s_cb_canal[c]) s_cb_canal[c](c);
+    }
 }
 
-void hal_tiempo_periodico_config_tick(uint32_t periodo_en_tick) {
+static void canales_iniciar(void) {
+    NRF_TIMER3->TASKS_STOP = 1;
+    NRF_TIMER3->TASKS_CLEAR = 1;
+    NRF_TIMER3->MODE = TIMER_MODE_MODE_Timer;
+    NRF_TIMER3->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+    NRF_TIMER3->PRESCALER = 0;             /* 16 MHz, misma base que TIMER1 */
+    NRF_TIMER3->SHORTS = 0;                /* libre: los canales comparan y suman */
+    s_canales_activos = 0;
+    NVIC_EnableIRQ(TIMER3_IRQn);
+    NRF_TIMER3->TASKS_START = 1;
+}
+
+void hal_tiempo_canal_config_tick(uint8_t canal, uint32_t periodo_en_tick, bool periodico) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
     /* Config sin arrancar */
-    NRF_TIMER0->TASKS_STOP = 1;
-    NRF_TIMER0->TASKS_CLEAR = 1;
+    hal_tiempo_canal_enable(canal, false);
+    s_periodo_canal[canal] = periodo_en_tick;
+    s_periodico_canal[canal] = periodico;
+}
 
-    if (periodo_en_tick == 0) return;
+void hal_tiempo_canal_set_callback(uint8_t canal, void (*cb)(uint8_t canal)) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    s_cb_canal[canal] = cb;
+}
+
+void hal_tiempo_canal_enable(uint8_t canal, bool enable) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    NRF_TIMER3->INTENCLR = (TIMER_INTENSET_COMPARE0_Msk << canal);
+    s_canales_activos &= ~(1u << canal);
+    s_canales_forzados &= ~(1u << canal);
+    NRF_TIMER3->EVENTS_COMPARE[canal] = 0;
+    if (enable && s_periodo_canal[canal] != 0) {
+        s_canales_activos |= (1u << canal);
+        canal_programar(canal, timer3_ahora());
+        NRF_TIMER3->INTENSET = (TIMER_INTENSET_COMPARE0_Msk << canal);
+    }
+}
+
+/* ***************************************************************************** */
+
+/* ---- Alarma one-shot con T1 CC[2] ----------------------------------------- */
 
-    NRF_TIMER0->MODE = TIMER_MODE_MODE_Timer;
-    NRF_TIMER0->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
-    NRF_TIMER0->PRESCALER = 0; // 64 MHz
+void hal_tiempo_alarma_tick(uint64_t deadline_tick, void (*funcion_callback_drv)()) {
+    NRF_TIMER1->INTENCLR = TIMER_INTENCLR_COMPARE2_Msk;	// desarmar mientras se reconfigura
+    s_cb_alarma = 0;
+    if (funcion_callback_drv == NULL) return;
 
-    NRF_TIMER0->CC[0] = periodo_en_tick - 1u;
-    NRF_TIMER0->INTENSET = TIMER_INTENSET_COMPARE0_Msk;
+    s_alarma_tick = deadline_tick;
+    s_cb_alarma = funcion_callback_drv;
+    NRF_TIMER1->CC[2] = (uint32_t)deadline_tick;	// salta en cada vuelta, la ISR filtra
+    NRF_TIMER1->EVENTS_COMPARE[2] = 0;
+    NRF_TIMER1->INTENSET = TIMER_INTENSET_COMPARE2_Msk;
 
-    NRF_TIMER0->SHORTS = TIMER_SHORTS_COMPARE0_CLEAR_Msk; // Reset automtico al comparar
+    /* si el instante ya paso (o paso mientras configurabamos) forzamos la IRQ */
+    if (hal_tiempo_actual_tick64() >= deadline_tick) {
+        NVIC_SetPendingIRQ(IRQ_ALARMA);
+    }
 }
 
-void hal_tiempo_periodico_set_callback(void (*cb)()) {
-    s_cb = cb;
+void hal_tiempo_alarma_cancelar(void) {
+    NRF_TIMER1->INTENCLR = TIMER_INTENCLR_COMPARE2_Msk;
+    s_cb_alarma = 0;
+    NRF_TIMER1->EVENTS_COMPARE[2] = 0;
 }
 
-void hal_tiempo_periodico_enable(bool enable) {
-    if (enable) {
-        NVIC_EnableIRQ(TIMER0_IRQn);
-        NRF_TIMER0->TASKS_START = 1;
+/* Sin alta resolucion que encender: TIMER1 ya es la base de tiempo */
+void hal_tiempo_reloj_rapido(bool encender) {
+    (void)encender;
+}
 
-    } else {
-        NRF_TIMER0->TASKS_STOP = 1;
-        NVIC_DisableIRQ(TIMER0_IRQn);
+void hal_tiempo_alta_resolucion(bool activar) {
+    (void)activar;
+}
+
+/* TIMER3 cuenta a la misma frecuencia que TIMER1: lo que le falta a cada CC vale en ticks */
+uint64_t hal_tiempo_proximo_tick(void) {
+    uint64_t ahora = hal_tiempo_actual_tick64();
+    uint64_t proximo = s_cb_alarma ? s_alarma_tick : HAL_TIEMPO_NUNCA;
+    uint32_t cuenta = timer3_ahora();
+
+    for (uint8_t c = 0; c < HAL_TIEMPO_CANALES; c++) {
+        if ((s_canales_activos & (1u << c)) == 0) continue;
+        if (s_canales_forzados & (1u << c)) return ahora;
+        uint64_t t = ahora + (uint32_t)(NRF_TIMER3->CC[c] - cuenta);
+        if (t < proximo) proximo = t;
     }
+    return proximo;
+}
+
+#endif /* HAL_TIEMPO_RTC */
+
+uint32_t hal_tiempo_captura_tarea(uint8_t n) {
+    if (n >= HAL_TIEMPO_CAPTURAS) return 0;
+    return (uint32_t)&NRF_TIMER4->TASKS_CAPTURE[n];
+}
+
+uint32_t hal_tiempo_disparo_evento(uint8_t n) {
+    if (n >= HAL_TIEMPO_DISPAROS) return 0;
+    return (uint32_t)&NRF_TIMER4->EVENTS_COMPARE[k_cc_disparo[n]];
+}
+
+bool hal_tiempo_disparo_tick(uint8_t n, uint64_t deadline_tick) {
+    if (n >= HAL_TIEMPO_DISPAROS || !s_captura_activa) return false;
+    uint8_t cc = k_cc_disparo[n];
+
+    /* TIMER4 va a la misma frecuencia que la base: la distancia vale igual en las dos.
+     * No se mide capturando en el CC: con la cuenta recien copiada el comparador
+     * coincidiria y su evento arrancaria lo que este enlazado por PPI. */
+    uint64_t ahora = hal_tiempo_actual_tick64();
+    if (deadline_tick <= ahora + DISPARO_MARGEN || deadline_tick - ahora > COUNTER_MAX) return false;
+
+    NRF_TIMER4->CC[cc] = (uint32_t)(deadline_tick - s_base_captura) - s_desfase_captura;
+    NRF_TIMER4->EVENTS_COMPARE[cc] = 0;
+    return true;
+}
+
+bool hal_tiempo_disparo_saltado(uint8_t n) {
+    if (n >= HAL_TIEMPO_DISPAROS) return false;
+    return NRF_TIMER4->EVENTS_COMPARE[k_cc_disparo[n]] != 0;
+}
+
+bool hal_tiempo_captura_tick64(uint8_t n, uint64_t *tick) {
+    if (n >= HAL_TIEMPO_CAPTURAS || !s_captura_activa) return false;
+
+    /* La captura es anterior a ahora: retroceder la distancia en 32 bits */
+    uint64_t ahora = hal_tiempo_actual_tick64();
+    uint32_t t1_captura = NRF_TIMER4->CC[n] + s_desfase_captura;
+    uint32_t t1_ahora = (uint32_t)(ahora - s_base_captura);
+    *tick = ahora - (uint32_t)(t1_ahora - t1_captura);
+    return true;
 }
- 
 
-void hal_tiempo_reloj_periodico_tick(uint32_t periodo_en_tick, void (*funcion_callback_drv)(void)){
+void hal_tiempo_canal_tick(uint8_t canal, uint32_t periodo_en_tick, bool periodico, void (*funcion_callback_drv)(uint8_t canal)) {
     /* 1) Deshabilitar antes de tocar config/callback (evita ISR en mitad de cambios) */
-    hal_tiempo_periodico_enable(false);
+    hal_tiempo_canal_enable(canal, false);
 
     /* 2) Registrar callback (puede ser NULL si vamos a deshabilitar) */
-    hal_tiempo_periodico_set_callback(funcion_callback_drv);
+    hal_tiempo_canal_set_callback(canal, funcion_callback_drv);
 
-    /* 3) Configurar periodo (no arranca el temporizador) */
-    hal_tiempo_periodico_config_tick(periodo_en_tick);
+    /* 3) Configurar periodo (no arranca el canal) */
+    hal_tiempo_canal_config_tick(canal, periodo_en_tick, periodico);
 
-    /* 4) Habilitar si hay periodo vlido y callback no nulo; deshabilitar en caso contrario */
+    /* 4) Habilitar si hay periodo valido y callback no nulo */
     if (periodo_en_tick != 0u && funcion_callback_drv != NULL) {
-        hal_tiempo_periodico_enable(true);
-    } else {
-        hal_tiempo_periodico_enable(false);
+        hal_tiempo_canal_enable(canal, true);
     }
 }
+
+uint32_t hal_tiempo_ciclos(void) {
+    return DWT->CYCCNT;
+}
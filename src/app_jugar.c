@@ -8,6 +8,7 @@
 #include "drv_tiempo.h"     // Para drv_tiempo_actual_ms
 #include "drv_WDT.h"
 #include "drv_SC.h"
+#include "svc_q16.h"
 #include "board.h"
 
 
@@ -91,7 +92,7 @@ void app_juego_actualizar(EVENTO_T evento, uint32_t auxData) {
 						int sc = drv_SC_entrar_disable_irq();
 
 					  drv_WDT_alimentar(); //
-				    drv_SC_salir_enable_irq();
+				    drv_SC_salir_enable_irq(sc);
 
             if (s_estado == e_JUEGO_JUGANDO) {
                 // auxData contiene el ID del botón pulsado
@@ -104,7 +105,7 @@ void app_juego_actualizar(EVENTO_T evento, uint32_t auxData) {
                     drv_led_establecer(s_led_actual+1, LED_OFF);
                     
                     // 3. Aumentar dificultad (reducir retardo)
-                    s_retardo_actual_ms = (uint32_t)(s_retardo_actual_ms * 0.95);
+                    s_retardo_actual_ms = q16_escalar(s_retardo_actual_ms, Q16_FRAC(95, 100));
                     if (s_retardo_actual_ms < 300) { // Poner un límite
                         s_retardo_actual_ms = 300;
                     }
@@ -7,21 +7,35 @@
 #include "board.h"
 #include "rt_GE.h"
 #include "svc_alarmas.h"
+#include "svc_gestos.h"
+#include "svc_partitura.h"
+#include "svc_q16.h"
 #include "drv_leds.h"
 #include "drv_botones.h"
 #include "drv_tiempo.h"
 #include "drv_aleatorios.h"
 #include "drv_sonido.h"
+#include "svc_almacen.h"
 
 // Configuración
-#define MAX_COMPASES_PARTIDA    30
 #define SCORE_MIN_FAIL          -5
 #define BPM_INICIAL             60
-#define MS_POR_MINUTO           60000
+
+// Ventanas de puntuación (fracción del compás, en coma fija: sin float ni división)
+#define VENTANA_PERFECTO        Q16_FRAC(11, 100)   // hasta el 11%
+#define VENTANA_BUENO           Q16_FRAC(21, 100)   // hasta el 21%
+#define VENTANA_NORMAL          Q16_FRAC(41, 100)   // hasta el 41%
 #define TIEMPO_REINICIO_MS      3000
+#define PERIODO_DEMO_MS         500
+
+// Holguras: alarmas que pueden vencer algo tarde y compartir despertar
+#define HOLGURA_DEMO_MS         50
+
+// Claves del almacén persistente (svc_almacen)
+#define CLAVE_RECORD            1
+#define CLAVE_HISTORICO         2
 
 // IDs Mágicos
-#define ID_ALARMA_RESET         50  
 #define ID_ALARMA_TICK          100
 #define ID_ALARMA_DEMO          200
 
@@ -51,25 +65,76 @@ typedef struct {
 
 volatile BeatHeroStats_t juego_stats = {0};
 
+// Acumulado de todas las partidas: se guarda en flash y sobrevive al apagado
+typedef struct {
+    uint32_t Partidas;
+    uint32_t Victorias;
+    uint32_t NotasAcertadas;
+    uint32_t NotasFalladas;
+    uint32_t AciertosPerfectos;
+    uint32_t MaxCombo;
+} BeatHeroHistorico_t;
+
+volatile BeatHeroHistorico_t juego_historico = {0};
+
 // Variables de Estado
 static uint8_t compas[3]; 
+static Tiempo_us_t duracion_compas_us[3];       // Duración de cada compás de compas[] (tempo de la partitura)
 typedef enum { e_INIT, e_JUEGO, e_RESULTADO } GameState_t;
 static GameState_t s_estado = e_INIT;
 
 static int32_t  s_score = 0;
 static int32_t  s_high_score = 0; 
 static uint32_t s_compases_jugados = 0;
-static uint32_t s_duracion_compas_ms = 1000;
+static Tiempo_us_t s_duracion_compas_us = 1000000;
 static Tiempo_us_t s_tiempo_inicio_compas = 0;
+static Tiempo_us_t s_proximo_compas_us = 0;     // Instante exacto del siguiente compás
 static uint8_t  s_nivel_dificultad = 1;
 
+// Melodías de fin de partida: const en flash, el PWM las lee por DMA sin la CPU
+static const drv_sonido_nota_t MELODIA_VICTORIA[] = {
+    {523, 120, 50}, {659, 120, 50}, {784, 120, 50}, {0, 40, 0}, {1047, 300, 50}
+};
+static const drv_sonido_nota_t MELODIA_DERROTA[] = {
+    {392, 200, 50}, {330, 200, 50}, {262, 400, 25}
+};
+
+// Un periodo de seno (tabla de onda): el acierto suena por PCM donde la placa lo permite
+static const int8_t ONDA_SENO[32] = {
+    0, 25, 49, 71, 90, 106, 117, 125, 127, 125, 117, 106, 90, 71, 49, 25,
+    0, -25, -49, -71, -90, -106, -117, -125, -127, -125, -117, -106, -90, -71, -49, -25
+};
+#define TONO_PERFECTO_HZ        880
+#define TONO_ACIERTO_HZ         660
+#define TONO_ACIERTO_MS         60
+
+// Click del metrónomo: lo arranca el hardware en el instante del compás
+#define CLICK_HZ                2000
+#define CLICK_MS                5
+
+// Partitura en curso: solo la posición de lectura está en RAM, las notas se leen de flash
+static svc_partitura_cursor_t s_partitura;
+static bool s_partitura_agotada = false;
+// Paso leído un compás antes de entrar en compas[2]: el marco de LEDs del siguiente
+// compás se arma por adelantado y lo muestra el hardware en el instante del pulso
+static uint8_t s_paso_leido = 0;
+static bool s_paso_leido_fin = false;           // la lectura adelantada llegó a FIN
+static Tiempo_us_t s_duracion_leida = 0;
+static bool s_marco_armado = false;             // el marco del próximo pulso lo pone el hardware
+static q16_tempo_t s_tempo;                     // Periodo de paso con fracción acumulada
+static uint16_t s_tempo_paso_ms = 0;            // TEMPO de la partitura que refleja s_tempo
+
 // Prototipos
 static void reiniciar_variables_juego(void);
 static void avanzar_compas(void);
+static void leer_paso(void);
+static void armar_marco_siguiente(void);
+static uint8_t paso_aleatorio(uint8_t nivel);
 static void actualizar_leds_display(void);
-static void evaluar_jugada(uint8_t botones_pulsados);
+static void evaluar_jugada(uint8_t botones_pulsados, Tiempo_us_t marca_pulsacion);
 static void programar_siguiente_tick(void);
 static void finalizar_partida(bool exito);
+static void guardar_estadisticas(bool exito);
 static int calcular_puntuacion(Tiempo_us_t now);
 
 // Función de actualización principal
@@ -78,20 +143,30 @@ void beat_hero_actualizar(EVENTO_T evento, uint32_t auxData);
 void beat_hero_iniciar(void) {
     s_estado = e_INIT;
     s_high_score = 0; 
+    // Récord e histórico de la flash (si no hay, se quedan a cero)
+    svc_almacen_leer(CLAVE_RECORD, &s_high_score, sizeof(s_high_score));
+    svc_almacen_leer(CLAVE_HISTORICO, (void*)&juego_historico, sizeof(BeatHeroHistorico_t));
+    juego_stats.HighScore = s_high_score;
 
     rt_GE_suscribir(ev_JUEGO_NUEVO_LED, 1, beat_hero_actualizar);
     rt_GE_suscribir(ev_PULSAR_BOTON, 1, beat_hero_actualizar);
     rt_GE_suscribir(ev_SOLTAR_BOTON, 1, beat_hero_actualizar);
     rt_GE_suscribir(ev_JUEGO_TIMEOUT, 1, beat_hero_actualizar); 
+    rt_GE_suscribir(ev_GESTO, 1, beat_hero_actualizar);
+    rt_GE_suscribir(ev_SONIDO_FIN, 1, beat_hero_actualizar);
+
+    // Solo interesa la pulsacion larga de reinicio: el resto de gestos, apagados
+    static const svc_gestos_config_t gestos = { TIEMPO_REINICIO_MS, 0, 0, 0, 0 };
+    svc_gestos_configurar(&gestos);
     
     reiniciar_variables_juego(); 
-    svc_alarma_activar(svc_alarma_codificar(false, 500, ID_ALARMA_DEMO), ev_JUEGO_NUEVO_LED, ID_ALARMA_DEMO);
+    svc_alarma_activar_holgura(svc_alarma_codificar(false, PERIODO_DEMO_MS, ID_ALARMA_DEMO), ev_JUEGO_NUEVO_LED, ID_ALARMA_DEMO, HOLGURA_DEMO_MS);
 }
 
 void beat_hero_actualizar(EVENTO_T evento, uint32_t auxData) {
     
     if (s_estado == e_JUEGO && (evento == ev_PULSAR_BOTON || evento == ev_SOLTAR_BOTON)) {
-        svc_alarma_activar(svc_alarma_codificar(false, 10000, 0), ev_INACTIVIDAD, 0);
+        svc_alarma_activar_holgura(svc_alarma_codificar(false, RT_GE_INACTIVIDAD_MS, 0), ev_INACTIVIDAD, 0, RT_GE_HOLGURA_INACTIVIDAD_MS);
     }
 
     switch (s_estado) {
@@ -102,7 +177,7 @@ void beat_hero_actualizar(EVENTO_T evento, uint32_t auxData) {
                 drv_led_establecer(led_demo, LED_OFF);
                 led_demo = (led_demo % LEDS_NUMBER) + 1;
                 drv_led_establecer(led_demo, LED_ON);
-                svc_alarma_activar(svc_alarma_codificar(false, 500, ID_ALARMA_DEMO), ev_JUEGO_NUEVO_LED, ID_ALARMA_DEMO);
+                svc_alarma_activar_holgura(svc_alarma_codificar(false, PERIODO_DEMO_MS, ID_ALARMA_DEMO), ev_JUEGO_NUEVO_LED, ID_ALARMA_DEMO, HOLGURA_DEMO_MS);
             }
             
             if (evento == ev_PULSAR_BOTON && (auxData == 2 || auxData == 3)) {
@@ -110,13 +185,28 @@ void beat_hero_actualizar(EVENTO_T evento, uint32_t auxData) {
             }
 
             if (evento == ev_PULSAR_BOTON && (auxData == 0 || auxData == 1)) {
+                // El botón elige la partitura (0: Clasica aleatoria, 1: Tutorial fija)
+                uint8_t n = (auxData < g_num_partituras) ? (uint8_t)auxData : 0;
                 svc_alarma_activar(0, ev_JUEGO_NUEVO_LED, ID_ALARMA_DEMO);
                 for(int i=1; i<=LEDS_NUMBER; i++) drv_led_establecer(i, LED_OFF);
                 
                 s_estado = e_JUEGO;
+                // Nada de borrados de flash (CPU parada decenas de ms) con la partida en marcha
+                svc_almacen_diferir(true);
+                // La puntuación compara instantes al µs: reloj rápido solo durante la partida
+                drv_tiempo_alta_resolucion(true);
                 reiniciar_variables_juego();
-                s_duracion_compas_ms = MS_POR_MINUTO / BPM_INICIAL;
+                // Hasta el primer TEMPO de la partitura (paso_ms 0), BPM_INICIAL
+                svc_partitura_abrir(&s_partitura, &g_partituras[n], 0);
+                s_partitura_agotada = false;
+                s_paso_leido_fin = false;
+                q16_tempo_bpm(&s_tempo, Q16_ENTERO(BPM_INICIAL));
+                s_tempo_paso_ms = 0;
+                s_duracion_compas_us = q16_tempo_siguiente_us(&s_tempo);
+                leer_paso();
+                s_proximo_compas_us = drv_tiempo_actual_us();
                 programar_siguiente_tick();
+                armar_marco_siguiente();
             }
             break;
 
@@ -127,7 +217,8 @@ void beat_hero_actualizar(EVENTO_T evento, uint32_t auxData) {
             }
 
             if (evento == ev_JUEGO_NUEVO_LED && auxData == ID_ALARMA_TICK) {
-                if (s_compases_jugados >= MAX_COMPASES_PARTIDA) {
+                // Victoria al acabar la partitura y no quedar notas por delante
+                if (s_partitura_agotada && compas[1] == 0 && compas[2] == 0) {
                     finalizar_partida(true); 
                     return;
                 }
@@ -137,23 +228,21 @@ void beat_hero_actualizar(EVENTO_T evento, uint32_t auxData) {
                 }
 
                 avanzar_compas();
-                actualizar_leds_display();
-                
-                if (s_compases_jugados % 5 == 0 && s_compases_jugados > 0) {
-                    s_nivel_dificultad++;
-                    if(s_nivel_dificultad > 4) s_nivel_dificultad = 4;
-                    if (s_nivel_dificultad == 4) s_duracion_compas_ms = (uint32_t)(s_duracion_compas_ms * 0.9f);
-                    juego_stats.Nivel = s_nivel_dificultad;
-                }
+                // Normalmente ya lo ha mostrado el hardware justo en el pulso; si no se pudo
+                // armar (instante pasado, sin temporizador) se pinta aquí como antes
+                if (!s_marco_armado) actualizar_leds_display();
 
-                s_tiempo_inicio_compas = drv_tiempo_actual_us();
+                // El compás empieza en el instante programado, no cuando se despacha el evento
+                s_tiempo_inicio_compas = s_proximo_compas_us;
                 s_compases_jugados++; 
                 juego_stats.CompasActual = s_compases_jugados;
 
                 programar_siguiente_tick();
+                armar_marco_siguiente();
             }
             else if (evento == ev_PULSAR_BOTON && auxData <= 1) {
-                evaluar_jugada(1 << auxData);
+                // Se juzga el instante real del flanco, no el de la confirmación (TRP + cola)
+                evaluar_jugada(1 << auxData, drv_botones_marca_pulsacion((uint8_t)auxData));
                 if (s_score < SCORE_MIN_FAIL) {
                     finalizar_partida(false);
                 }
@@ -161,20 +250,17 @@ void beat_hero_actualizar(EVENTO_T evento, uint32_t auxData) {
             break;
 
         case e_RESULTADO:
-            if (evento == ev_PULSAR_BOTON && (auxData == 2 || auxData == 3)) {
-                svc_alarma_activar(0, ev_JUEGO_TIMEOUT, ID_ALARMA_RESET);
-                uint32_t flags = svc_alarma_codificar(false, TIEMPO_REINICIO_MS, ID_ALARMA_RESET);
-                svc_alarma_activar(flags, ev_JUEGO_TIMEOUT, ID_ALARMA_RESET);
-            }
-            
-            if (evento == ev_SOLTAR_BOTON && (auxData == 2 || auxData == 3)) {
-                svc_alarma_activar(0, ev_JUEGO_TIMEOUT, ID_ALARMA_RESET);
+            // Acabada la melodía ya no hay nada que atender a tiempo: se puede escribir la flash
+            if (evento == ev_SONIDO_FIN) {
+                svc_almacen_diferir(false);
             }
-            
-            if (evento == ev_JUEGO_TIMEOUT && auxData == ID_ALARMA_RESET) {
+            // Mantener el boton 3 o 4 TIEMPO_REINICIO_MS (pulsacion larga de svc_gestos)
+            if (evento == ev_GESTO && SVC_GESTO_TIPO(auxData) == SVC_GESTO_LARGA &&
+                (SVC_GESTO_DATO(auxData) == 2 || SVC_GESTO_DATO(auxData) == 3)) {
                 reiniciar_variables_juego();
                 s_estado = e_INIT;
-                svc_alarma_activar(svc_alarma_codificar(false, 500, ID_ALARMA_DEMO), ev_JUEGO_NUEVO_LED, ID_ALARMA_DEMO);
+                svc_almacen_diferir(false);
+                svc_alarma_activar_holgura(svc_alarma_codificar(false, PERIODO_DEMO_MS, ID_ALARMA_DEMO), ev_JUEGO_NUEVO_LED, ID_ALARMA_DEMO, HOLGURA_DEMO_MS);
             }
             break;
             
@@ -184,7 +270,8 @@ void beat_hero_actualizar(EVENTO_T evento, uint32_t auxData) {
 
 static void finalizar_partida(bool exito) {
     s_estado = e_RESULTADO;
-    svc_alarma_activar(0, ev_JUEGO_NUEVO_LED, ID_ALARMA_TICK);
+    svc_alarma_cancelar_us(ev_JUEGO_NUEVO_LED, ID_ALARMA_TICK);
+    drv_tiempo_alta_resolucion(false);
     
     for(int i=1; i<=LEDS_NUMBER; i++) drv_led_establecer(i, LED_OFF);
     
@@ -194,10 +281,26 @@ static void finalizar_partida(bool exito) {
             s_high_score = s_score;
             juego_stats.HighScore = s_high_score; 
         }
+        drv_sonido_secuencia(MELODIA_VICTORIA, sizeof(MELODIA_VICTORIA) / sizeof(MELODIA_VICTORIA[0]), 1);
     } else {
         drv_led_establecer(1, LED_ON);
         drv_led_establecer(4, LED_ON);
+        drv_sonido_secuencia(MELODIA_DERROTA, sizeof(MELODIA_DERROTA) / sizeof(MELODIA_DERROTA[0]), 0);
     }
+    guardar_estadisticas(exito);
+}
+
+static void guardar_estadisticas(bool exito) {
+    juego_historico.Partidas++;
+    if (exito) juego_historico.Victorias++;
+    juego_historico.NotasAcertadas += juego_stats.NotasAcertadas;
+    juego_historico.NotasFalladas += juego_stats.NotasFalladas;
+    juego_historico.AciertosPerfectos += juego_stats.AciertosPerfectos;
+    if (juego_stats.MaxCombo > juego_historico.MaxCombo) juego_historico.MaxCombo = juego_stats.MaxCombo;
+
+    // Solo quedan pendientes en RAM: se escriben en los huecos ociosos tras la melodía
+    svc_almacen_guardar(CLAVE_RECORD, &s_high_score, sizeof(s_high_score));
+    svc_almacen_guardar(CLAVE_HISTORICO, (const void*)&juego_historico, sizeof(BeatHeroHistorico_t));
 }
 
 static void reiniciar_variables_juego(void) {
@@ -211,11 +314,11 @@ static void reiniciar_variables_juego(void) {
     s_score = 0; 
     s_compases_jugados = 0; 
     s_nivel_dificultad = 1; 
-    s_duracion_compas_ms = 1000;
+    s_duracion_compas_us = 1000000;
     compas[0]=0; compas[1]=0; compas[2]=0;
+    duracion_compas_us[0]=duracion_compas_us[1]=duracion_compas_us[2]=s_duracion_compas_us;
     
     for(int i=1; i<=LEDS_NUMBER; i++) drv_led_establecer(i, LED_OFF);
-    svc_alarma_activar(0, ev_JUEGO_TIMEOUT, ID_ALARMA_RESET);
 }
 
 static void avanzar_compas(void) {
@@ -227,13 +330,49 @@ static void avanzar_compas(void) {
     }
 
     compas[0] = compas[1]; compas[1] = compas[2];
-    uint32_t rnd = drv_aleatorios_rango(100);
+    duracion_compas_us[0] = duracion_compas_us[1]; duracion_compas_us[1] = duracion_compas_us[2];
+
+    // El compás que empieza ahora dura lo que marcaba la partitura al leerlo
+    s_duracion_compas_us = duracion_compas_us[0];
+
+    // Entra el paso leído en el compás anterior; tras FIN, compases vacíos
+    if (s_paso_leido_fin) {
+        s_partitura_agotada = true;
+        compas[2] = 0;
+        duracion_compas_us[2] = s_duracion_compas_us;
+    } else {
+        compas[2] = s_paso_leido;
+        duracion_compas_us[2] = s_duracion_leida;
+    }
+    leer_paso();
+}
+
+// Siguiente paso de la partitura (una lectura de flash), un compás antes de usarlo
+static void leer_paso(void) {
     uint8_t p = 0;
-    
-    if (s_nivel_dificultad == 1)       p = (rnd > 50) ? 1 : 2;
-    else if (s_nivel_dificultad == 2) p = (rnd < 20) ? 0 : ((rnd < 60) ? 1 : 2);
-    else                              p = (rnd < 15) ? 0 : ((rnd < 45) ? 1 : ((rnd < 75) ? 2 : 3));
-    compas[2] = p;
+    if (!s_paso_leido_fin && svc_partitura_siguiente(&s_partitura, &p)) {
+        s_nivel_dificultad = s_partitura.nivel;
+        juego_stats.Nivel = s_nivel_dificultad;
+        if (s_partitura.paso_ms != s_tempo_paso_ms) {
+            s_tempo_paso_ms = s_partitura.paso_ms;
+            q16_tempo_periodo_us(&s_tempo, (uint32_t)s_tempo_paso_ms * 1000u);
+        }
+        s_duracion_leida = q16_tempo_siguiente_us(&s_tempo);
+        if (p == SVC_PARTITURA_PASO_ALEATORIO) p = paso_aleatorio(s_nivel_dificultad);
+        s_paso_leido = p & 3;  // dos carriles: botones 0 y 1 (tools/partitura.py no genera más)
+    } else {
+        s_paso_leido_fin = true;
+        s_paso_leido = 0;
+    }
+}
+
+// Paso ALEATORIO de la partitura: el generador de siempre según el nivel
+static uint8_t paso_aleatorio(uint8_t nivel) {
+    uint32_t rnd = drv_aleatorios_rango(100);
+
+    if (nivel <= 1)       return (rnd > 50) ? 1 : 2;
+    else if (nivel == 2)  return (rnd < 20) ? 0 : ((rnd < 60) ? 1 : 2);
+    else                  return (rnd < 15) ? 0 : ((rnd < 45) ? 1 : ((rnd < 75) ? 2 : 3));
 }
 
 static void actualizar_leds_display(void) {
@@ -243,36 +382,60 @@ static void actualizar_leds_display(void) {
     drv_led_establecer(4, (compas[1] & 2) ? LED_ON : LED_OFF);
 }
 
+// Lo que mostrará actualizar_leds_display tras el próximo avanzar_compas, armado para
+// s_proximo_compas_us: compas[2] pasará a compas[1] y el paso leído a compas[2]
+static void armar_marco_siguiente(void) {
+    uint8_t siguiente = s_paso_leido_fin ? 0 : s_paso_leido;
+    drv_leds_marco_t marco = 0;
+    if (siguiente & 1)  marco |= DRV_LEDS_MARCO_LED(1);
+    if (siguiente & 2)  marco |= DRV_LEDS_MARCO_LED(2);
+    if (compas[2] & 1)  marco |= DRV_LEDS_MARCO_LED(3);
+    if (compas[2] & 2)  marco |= DRV_LEDS_MARCO_LED(4);
+    s_marco_armado = drv_leds_marco_en(marco, s_proximo_compas_us);
+}
+
 static void programar_siguiente_tick(void) {
-    svc_alarma_activar(svc_alarma_codificar(false, s_duracion_compas_ms, ID_ALARMA_TICK), ev_JUEGO_NUEVO_LED, ID_ALARMA_TICK);
+    // Plazo absoluto: el siguiente compás se mide desde el anterior, sin arrastrar latencias
+    s_proximo_compas_us += s_duracion_compas_us;
+    svc_alarma_activar_us(s_proximo_compas_us, 0, ev_JUEGO_NUEVO_LED, ID_ALARMA_TICK);
+    // El click no espera a la alarma ni al GE: suena justo en s_proximo_compas_us
+    drv_sonido_click(s_proximo_compas_us, CLICK_HZ, CLICK_MS);
 }
 
 static int calcular_puntuacion(Tiempo_us_t now) {
-    uint32_t diff_ms = (uint32_t)((now - s_tiempo_inicio_compas) / 1000);
-    juego_stats.UltimoTiempoReaccion_ms = diff_ms;
-    
-    if(s_duracion_compas_ms == 0) return 0;
-    uint32_t pct = (diff_ms * 100) / s_duracion_compas_ms;
+    if(s_duracion_compas_us == 0) return 0;
+    // Dentro del compás cabe en 32 bits; más allá es fallo por tiempo igualmente
+    Tiempo_us_t diff64 = now - s_tiempo_inicio_compas;
+    uint32_t diff_us = (diff64 > s_duracion_compas_us) ? (uint32_t)s_duracion_compas_us : (uint32_t)diff64;
+    uint32_t duracion_us = (uint32_t)s_duracion_compas_us;
+    juego_stats.UltimoTiempoReaccion_ms = (int32_t)(diff_us / 1000u);
     
     // --- LÓGICA CORREGIDA ---
-    // Aumentamos el margen de aciertos normales al 50% para ser más justos
-    if (pct <= 10) { 
+    // Perfecto / bueno / normal según la fracción del compás ya transcurrida
+    if (diff_us < q16_escalar(duracion_us, VENTANA_PERFECTO)) { 
         juego_stats.AciertosPerfectos++; 
         return 2; 
     }
-    if (pct <= 20) { 
+    if (diff_us < q16_escalar(duracion_us, VENTANA_BUENO)) { 
         juego_stats.AciertosBuenos++;    
         return 1; 
     }
-    if (pct <= 40) { // Antes era 40%, subido a 50%
+    if (diff_us < q16_escalar(duracion_us, VENTANA_NORMAL)) {
         juego_stats.AciertosNormales++;  
         return 0; 
     }
-    // Si tarda más del 50%, devuelve -1 (Fallo por tiempo)
+    // Si tarda más del 41%, devuelve -1 (Fallo por tiempo)
     return -1;
 }
 
-static void evaluar_jugada(uint8_t input_mask) {
+static void evaluar_jugada(uint8_t input_mask, Tiempo_us_t marca_pulsacion) {
+    // Flanco anterior al compás actual: la pulsación era del compás ya cerrado, en su
+    // último tramo (se confirma TRP después). Ahí habría valido -1, que es justo lo que
+    // avanzar_compas ya cobró por la nota sin tocar: no se vuelve a juzgar.
+    if (marca_pulsacion < s_tiempo_inicio_compas) {
+        return;
+    }
+
     if (compas[0] == 0) { 
         s_score--; 
         juego_stats.Score = s_score;
@@ -282,7 +445,7 @@ static void evaluar_jugada(uint8_t input_mask) {
     }
     
     if (compas[0] & input_mask) {
-        int puntos = calcular_puntuacion(drv_tiempo_actual_us());
+        int puntos = calcular_puntuacion(marca_pulsacion);
         s_score += puntos;
         compas[0] &= ~input_mask; 
         
@@ -292,6 +455,8 @@ static void evaluar_jugada(uint8_t input_mask) {
         // Solo contamos como "NotaAcertada" si puntos >= 0.
         // Si puntos es -1, fue un acierto de botón pero muy tarde (Miss)
         if (puntos >= 0) {
+            drv_sonido_onda(0, ONDA_SENO, sizeof(ONDA_SENO),
+                            (puntos == 2) ? TONO_PERFECTO_HZ : TONO_ACIERTO_HZ, TONO_ACIERTO_MS, 2);
             juego_stats.NotasAcertadas++;
             juego_stats.ComboActual++;
             if (juego_stats.ComboActual > juego_stats.MaxCombo) {
@@ -303,7 +468,7 @@ static void evaluar_jugada(uint8_t input_mask) {
                 juego_stats.PromedioReaccion_ms = (int32_t)(juego_stats.SumaTiemposReaccion / juego_stats.NotasAcertadas);
             }
         } else {
-            // Acierto de botón pero fuera de tiempo (>50%)
+            // Acierto de botón pero fuera de tiempo (>41%)
             juego_stats.NotasFalladas++;
             juego_stats.ComboActual = 0;
         }
@@ -4,19 +4,82 @@
 #include "drv_SC.h"
 #include "hal_SC.h"
 
-static uint32_t m_in_critical_region = 0;
+#ifdef DEBUG
+#include "drv_tiempo.h"
+#include "board.h"
 
-uint32_t drv_SC_entrar_disable_irq(void){
-    // Deshabilita las interrupciones y devuelve el estado actual de la región crítica
-    deshabilitar_irq();
-    return(m_in_critical_region++);
+/* Dirección de retorno de la llamada a drv_SC_entrar_disable_irq: la instrucción
+ * siguiente en quien entró (buscarla en el .map o en el desensamblado) */
+#if defined(__CC_ARM)
+#define SC_LLAMANTE()  ((uint32_t)__return_address())
+#else
+#define SC_LLAMANTE()  ((uint32_t)(uintptr_t)__builtin_return_address(0))
+#endif
+
+// --- VARIABLES GLOBALES DE DEPURACIÓN (Sin static, con volatile) ---
+// Solo la sección más exterior: es lo que tarda una IRQ del runtime en poder entrar
+volatile uint32_t dbg_sc_max_ciclos = 0;
+volatile uint32_t dbg_sc_max_us = 0;
+volatile uint32_t dbg_sc_max_llamante = 0;   // SC_LLAMANTE de la sección más larga
+volatile uint32_t dbg_sc_hist[DRV_SC_HIST] = {0,0,0,0,0};
+
+static uint32_t s_inicio_ciclos = 0;
+static uint32_t s_llamante = 0;
+static bool s_midiendo = false;        // dentro de la sección más exterior
+static uint32_t s_pausa_ciclos = 0;
+
+// Llamar aún dentro de la sección: nada la interrumpe mientras se apunta
+static void medir_salida(void) {
+    uint32_t ciclos = drv_tiempo_ciclos() - s_inicio_ciclos;
+    s_midiendo = false;
+
+    // Umbrales en ciclos (constantes): sin dividir en cada salida
+    if (ciclos < 1u * CPU_CLOCK_MHZ)        dbg_sc_hist[0]++;
+    else if (ciclos < 5u * CPU_CLOCK_MHZ)   dbg_sc_hist[1]++;
+    else if (ciclos < 20u * CPU_CLOCK_MHZ)  dbg_sc_hist[2]++;
+    else if (ciclos < 100u * CPU_CLOCK_MHZ) dbg_sc_hist[3]++;
+    else                                    dbg_sc_hist[4]++;
+
+    if (ciclos > dbg_sc_max_ciclos) {
+        dbg_sc_max_ciclos = ciclos;
+        dbg_sc_max_us = ciclos / CPU_CLOCK_MHZ;
+        dbg_sc_max_llamante = s_llamante;
+    }
 }
 
-void drv_SC_salir_enable_irq(void){
-    // Restaura el estado previo de las interrupciones
-    m_in_critical_region--;
-    if (m_in_critical_region == 0) {
-        habilitar_irq();
+/* Una IRQ que despierta el WFI queda pendiente hasta salir: su espera empieza al
+ * despertar, no al dormir. En LPC los ciclos salen de T1, que sigue contando en
+ * Idle; en nRF el DWT ya se para. Fuera de una sección no hacen nada. */
+void drv_SC_medida_pausar(void) {
+    if (s_midiendo) s_pausa_ciclos = drv_tiempo_ciclos();
+}
+
+void drv_SC_medida_reanudar(void) {
+    if (s_midiendo) s_inicio_ciclos += drv_tiempo_ciclos() - s_pausa_ciclos;
+}
+#endif
+
+void drv_SC_iniciar(void){
+    hal_SC_iniciar();
+}
+
+uint32_t drv_SC_entrar_disable_irq(void){
+    // Bloquea las IRQ del runtime y devuelve el estado previo para restaurarlo al salir
+    uint32_t estado = hal_SC_entrar();
+#ifdef DEBUG
+    if (estado == HAL_SC_ESTADO_LIBRE) {
+        s_llamante = SC_LLAMANTE();
+        s_inicio_ciclos = drv_tiempo_ciclos();
+        s_midiendo = true;
     }
+#endif
+    return estado;
 }
 
+void drv_SC_salir_enable_irq(uint32_t estado){
+#ifdef DEBUG
+    if (estado == HAL_SC_ESTADO_LIBRE) medir_salida();
+#endif
+    // Restaura el estado previo: una sección anidada no rehabilita nada
+    hal_SC_salir(estado);
+}
@@ -7,21 +7,46 @@
 
 
 /**
- * @brief Entra en una sección crítica y deshabilita las interrupciones.
+ * @brief Prepara las prioridades de IRQ (hal_SC_iniciar).
  *
- * Esta función anida llamadas, manteniendo las interrupciones deshabilitadas
- * hasta que la última llamada a drv_SC_salir_enable_irq se ejecute.
+ * Llamar lo primero en main(), antes de iniciar ningún periférico.
+ */
+void drv_SC_iniciar(void);
+
+/**
+ * @brief Entra en una sección crítica y bloquea las interrupciones del runtime.
  *
- * @return El contador de nivel de anidamiento de la sección crítica (para depuración).
+ * En nRF sube BASEPRI: las IRQ de HAL_SC_PRIORIDAD_CRITICA siguen entrando.
+ * En LPC deshabilita todas.
+ *
+ * @return El estado de enmascarado previo, a pasar a drv_SC_salir_enable_irq.
  */
 uint32_t drv_SC_entrar_disable_irq(void);
 
 /**
- * @brief Sale de una sección crítica y habilita las interrupciones.
+ * @brief Sale de una sección crítica restaurando el estado de su entrada.
  *
- * Si es la última salida anidada, las interrupciones se habilitan.
+ * Las secciones se pueden anidar: solo la más exterior vuelve a habilitar.
  */
-void drv_SC_salir_enable_irq(void);
+void drv_SC_salir_enable_irq(uint32_t estado);
+
+#ifdef DEBUG
+/* Duración de la sección más exterior (la que retrasa a las IRQ del runtime),
+ * medida con drv_tiempo_ciclos: [0]:<1us, [1]:<5us, [2]:<20us, [3]:<100us, [4]:>=100us.
+ * También dbg_sc_max_ciclos / dbg_sc_max_us y dbg_sc_max_llamante en drv_SC.c. */
+#define DRV_SC_HIST 5
+extern volatile uint32_t dbg_sc_hist[DRV_SC_HIST];
+extern volatile uint32_t dbg_sc_max_ciclos;
+extern volatile uint32_t dbg_sc_max_us;
+
+/* Descuentan de la sección en curso el tramo dormido entre ambas (WFI dentro de
+ * la sección, p.ej. drv_tiempo_esperar_ms): lo llama drv_consumo_esperar */
+void drv_SC_medida_pausar(void);
+void drv_SC_medida_reanudar(void);
+#else
+#define drv_SC_medida_pausar()    ((void)0)
+#define drv_SC_medida_reanudar()  ((void)0)
+#endif
 
 
 #endif /* DRV_SC_H */
@@ -5,6 +5,7 @@
 #include "drv_botones.h"
 #include "drv_monitor.h"
 #include "drv_tiempo.h"
+#include "drv_SC.h"
 #include "svc_alarmas.h"
 #include "rt_GE.h"
 
@@ -12,17 +13,41 @@
 #include "hal_ext_int.h"
 
 // Tiempos para el filtrado de rebotes (Debounce)
-#define TRP_MS 80   // Tiempo Rebote Pulsado: Espera inicial tras detectar flanco
+#define TRP_MS 80   // Tiempo Rebote Pulsado: Espera inicial tras detectar flanco (maximo)
 #define TEP_MS 50   // Tiempo Entre Pulsaciones: Periodo de muestreo para detectar soltado
-#define TRD_MS 50   // Tiempo Rebote Despulsado: Espera final antes de rehabilitar IRQ
+#define TEP_HOLGURA_MS 10 // El muestreo del soltado admite retraso: comparte despertar con otras alarmas
+#define TRD_MS 50   // Tiempo Rebote Despulsado: Espera final antes de rehabilitar IRQ (maximo)
+
+// Autoajuste: TRP/TRD de cada boton siguen el rebote medido, entre estos limites
+#define TRP_MIN_MS 15
+#define TRD_MIN_MS 15
+#define REBOTE_MUESTREO_US 1000 // muestreo del pin mientras rebota
+#define REBOTE_ESTABLE_MS 5     // sin cambios este tiempo = asentado
+#define REBOTE_MARGEN_MS 5      // ventana = pico de rebote medido + margen
 
 #define NUM_BOTONES BUTTONS_NUMBER
 
+// Una marca hardware mas antigua que esto (o futura) no es de este flanco
+#define MARCA_FLANCO_MAX_US 50000
+
+// Sondeo puro (DRV_BOTONES_SONDEO): el escaneo sin interrupciones externas, para
+// placas con mas botones que lineas EINT/GPIOTE
+#if defined(DRV_BOTONES_SONDEO) && !defined(DRV_BOTONES_ESCANEO)
+#define DRV_BOTONES_ESCANEO
+#endif
+
+// Motor de escaneo (DRV_BOTONES_ESCANEO): periodo de muestreo del puerto
+#ifndef DRV_BOTONES_ESCANEO_MS
+#define DRV_BOTONES_ESCANEO_MS 10
+#endif
+#define ESCANEO_MUESTRAS 4  // muestras iguales seguidas para aceptar un cambio (contador de 2 bits)
+
 // Eventos que usaremos para notificar a la aplicacion
 static EVENTO_T m_ev_confirmado; 
 static EVENTO_T m_ev_soltado;    
 static EVENTO_T m_ev_retardo;    
 
+#if !defined(DRV_BOTONES_ESCANEO)
 // Estados de la Maquina de Estados (FSM) de cada boton
 typedef enum {
     e_esperando,  // IRQ habilitada, esperando pulsacion
@@ -34,26 +59,324 @@ typedef enum {
 // Estado individual para cada boton
 static volatile FsmEstado_t s_estado_botones[BUTTONS_NUMBER];
 
-// Mapeo de pines hardware
-static const HAL_GPIO_PIN_T s_pins_botones[BUTTONS_NUMBER] = {
-    BUTTON_1,
-    BUTTON_2,
-    BUTTON_3,
-#if BUTTONS_NUMBER > 3
-    BUTTON_4
+// Medida del rebote: un canal hardware muestrea los pines que estan rebotando
+static uint8_t s_canal_rebote = DRV_TIEMPO_SIN_CANAL;
+static volatile uint32_t s_midiendo = 0;                      // bit i = boton i
+static volatile uint8_t s_rebote_nivel[BUTTONS_NUMBER];       // ultimo nivel leido
+static volatile uint8_t s_rebote_flancos[BUTTONS_NUMBER];     // cambios de nivel vistos
+static volatile Tiempo_us_t s_rebote_inicio[BUTTONS_NUMBER];  // primer flanco
+static volatile Tiempo_us_t s_rebote_ultimo[BUTTONS_NUMBER];  // ultimo flanco
+
+// Ventanas en uso y pico de rebote (decae despacio) de cada boton
+static uint16_t s_trp_ms[BUTTONS_NUMBER];
+static uint16_t s_trd_ms[BUTTONS_NUMBER];
+static uint16_t s_pico_trp_ms[BUTTONS_NUMBER];
+static uint16_t s_pico_trd_ms[BUTTONS_NUMBER];
 #endif
-};
+
+static drv_botones_stats_t s_stats[BUTTONS_NUMBER];
+
+// Mapeo de pines hardware
+static const HAL_GPIO_PIN_T s_pins_botones[BUTTONS_NUMBER] = BUTTONS_LIST;
 
 static f_callback_GE drv_botones_isr_callback;
+static void (*drv_botones_encolar_ts)(uint32_t, uint32_t, Tiempo_us_t) = NULL;
+
+// Instante del primer flanco de cada boton (hardware si la placa lo captura)
+static volatile Tiempo_us_t s_marca_flanco[BUTTONS_NUMBER];
+
+// Botones que arrancaron la placa desde apagado y ya estaban soltados al iniciar
+static uint32_t s_despertar = 0;
+
+// Encola con marca de tiempo si hay funcion para ello (la FIFO pone la suya si no)
+static void notificar(EVENTO_T ev, uint32_t aux, Tiempo_us_t marca) {
+    if (drv_botones_encolar_ts) {
+        drv_botones_encolar_ts(ev, aux, marca);
+    } else {
+        drv_botones_isr_callback(ev, aux);
+    }
+}
+
+#ifdef DEBUG
+volatile uint32_t dbg_botones_marcas_hw = 0;     // flancos fechados por captura hardware
+volatile uint32_t dbg_botones_marcas_sw = 0;     // flancos fechados al entrar en la ISR
+volatile uint32_t dbg_botones_latencia_us = 0;   // ultima distancia flanco -> ISR
+volatile uint32_t dbg_botones_latencia_max_us = 0;
+#endif
+
+#if !defined(DRV_BOTONES_SONDEO)
+// Fecha el flanco que acaba de entrar por la ISR: el instante capturado por
+// hardware si lo hay y es coherente, si no el de ahora (incluye la latencia de la ISR)
+static Tiempo_us_t marcar_flanco(uint8_t id_boton) {
+    Tiempo_us_t ahora = drv_tiempo_actual_us();
+    Tiempo_us_t marca = ahora;
+    uint64_t tick;
+    if (hal_ext_int_marca_flanco(id_boton, &tick)) {
+        Tiempo_us_t hw = drv_tiempo_ticks_a_us(tick);
+        if (hw <= ahora && ahora - hw < MARCA_FLANCO_MAX_US) marca = hw;
+    }
+    s_marca_flanco[id_boton] = marca;
+
+#ifdef DEBUG
+    if (marca != ahora) {
+        dbg_botones_marcas_hw++;
+        dbg_botones_latencia_us = (uint32_t)(ahora - marca);
+        if (dbg_botones_latencia_us > dbg_botones_latencia_max_us) {
+            dbg_botones_latencia_max_us = dbg_botones_latencia_us;
+        }
+    } else {
+        dbg_botones_marcas_sw++;
+    }
+#endif
+    return marca;
+}
+#endif /* !DRV_BOTONES_SONDEO */
+
+#if !defined(DRV_BOTONES_ESCANEO)
+/* -----------------------------------------------------------------------------
+ * Autoajuste del antirrebote (FSM): mientras un boton esta en TRP o TRD un canal
+ * hardware lee su pin cada REBOTE_MUESTREO_US y apunta cuantos cambios hay y cuando
+ * fue el ultimo. La ventana solo se da por buena si el pin lleva REBOTE_ESTABLE_MS
+ * quieto (si no, se alarga hasta el maximo fijo), y la siguiente ventana se ajusta al
+ * pico de rebote medido + margen. Un interruptor limpio confirma antes sin perder
+ * la garantia del peor caso.
+ */
+#ifdef DEBUG
+volatile uint32_t dbg_botones_muestras_rebote = 0;
+#endif
+
+// Muestreo de los pines que estan rebotando (modo IRQ, desde el canal de drv_tiempo)
+static void rebote_cb(uint32_t id, uint32_t aux) {
+    (void)id;
+    (void)aux;
+    Tiempo_us_t ahora = drv_tiempo_actual_us();
+    uint32_t midiendo = s_midiendo;
+
+#ifdef DEBUG
+    dbg_botones_muestras_rebote++;
+#endif
+    for (uint8_t i = 0; i < NUM_BOTONES; i++) {
+        if ((midiendo & (1u << i)) == 0) continue;
+        uint8_t nivel = (hal_gpio_leer(s_pins_botones[i]) != 0);
+        if (nivel != s_rebote_nivel[i]) {
+            s_rebote_nivel[i] = nivel;
+            s_rebote_flancos[i]++;
+            s_rebote_ultimo[i] = ahora;
+        }
+    }
+}
+
+// Empieza a medir el rebote de un boton desde el flanco 'inicio' hacia 'nivel'
+static void rebote_medir(uint8_t id_boton, Tiempo_us_t inicio, uint8_t nivel) {
+    if (s_canal_rebote == DRV_TIEMPO_SIN_CANAL) return;
+
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    s_rebote_nivel[id_boton] = nivel;
+    s_rebote_flancos[id_boton] = 1;
+    s_rebote_inicio[id_boton] = inicio;
+    s_rebote_ultimo[id_boton] = inicio;
+    bool arrancar = (s_midiendo == 0);
+    s_midiendo |= (1u << id_boton);
+    drv_SC_salir_enable_irq(sc);
+
+    if (arrancar) drv_tiempo_canal_arrancar_us(s_canal_rebote, REBOTE_MUESTREO_US, true);
+}
+
+// Al vencer TRP/TRD: true si el pin ya esta asentado (o se llego a max_ms desde el
+// primer flanco). Si aun rebota, rearma la ventana lo justo y devuelve false
+static bool rebote_asentado(uint8_t id_boton, uint16_t max_ms) {
+    if ((s_midiendo & (1u << id_boton)) == 0) return true;
+
+    Tiempo_us_t ahora = drv_tiempo_actual_us();
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    uint32_t quieto_ms = drv_tiempo_us_a_ms(ahora - s_rebote_ultimo[id_boton]);
+    uint32_t total_ms = drv_tiempo_us_a_ms(ahora - s_rebote_inicio[id_boton]);
+    drv_SC_salir_enable_irq(sc);
+
+    if (quieto_ms < REBOTE_ESTABLE_MS && total_ms < max_ms) {
+        s_stats[id_boton].extensiones++;
+        uint32_t flags = svc_alarma_codificar(false, REBOTE_ESTABLE_MS - quieto_ms, id_boton);
+        svc_alarma_activar(flags, m_ev_retardo, id_boton);
+        return false;
+    }
+    return true;
+}
+
+// Cierra la medida y devuelve la ventana a usar la proxima vez
+static uint16_t rebote_adaptar(uint8_t id_boton, uint16_t *pico_ms, uint16_t min_ms, uint16_t max_ms) {
+    if ((s_midiendo & (1u << id_boton)) == 0) return max_ms;   // sin canal: ventanas fijas
+
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    s_midiendo &= ~(1u << id_boton);
+    bool parar = (s_midiendo == 0);
+    uint16_t rebote_ms = (uint16_t)drv_tiempo_us_a_ms(s_rebote_ultimo[id_boton] - s_rebote_inicio[id_boton] + 999u);
+    uint8_t flancos = s_rebote_flancos[id_boton];
+    drv_SC_salir_enable_irq(sc);
+
+    if (parar) drv_tiempo_canal_parar(s_canal_rebote);
+
+    drv_botones_stats_t *st = &s_stats[id_boton];
+    st->flancos += flancos;
+    st->rebote_ultimo_ms = rebote_ms;
+    if (rebote_ms > st->rebote_max_ms) st->rebote_max_ms = rebote_ms;
+
+    // Sube de golpe con un rebote largo; baja 1/8 de la diferencia por pulsacion
+    if (rebote_ms >= *pico_ms) *pico_ms = rebote_ms;
+    else *pico_ms -= (uint16_t)((*pico_ms - rebote_ms + 7u) / 8u);
+
+    uint32_t ventana = (uint32_t)*pico_ms + REBOTE_MARGEN_MS;
+    if (ventana < min_ms) ventana = min_ms;
+    if (ventana > max_ms) ventana = max_ms;
+    return (uint16_t)ventana;
+}
+#endif /* !DRV_BOTONES_ESCANEO */
+
+#if defined(DRV_BOTONES_ESCANEO)
+/* -----------------------------------------------------------------------------
+ * Motor de escaneo (alternativo a la FSM): un canal hardware de drv_tiempo lee de
+ * una vez el puerto de los botones cada DRV_BOTONES_ESCANEO_MS y filtra todos los
+ * botones a la vez con un contador vertical de 2 bits por pin (bit n de s_ct0/s_ct1
+ * = contador del pin n): un cambio solo vale tras ESCANEO_MUESTRAS lecturas iguales.
+ * Coste constante sea cual sea el numero de botones, sin alarmas ni eventos internos.
+ * Solo escanea mientras hay algo que filtrar: en reposo para el canal y el flanco
+ * (EINT/GPIOTE) lo vuelve a arrancar, asi que la CPU sigue durmiendo sin botones.
+ */
+static uint32_t s_mascara[HAL_GPIO_PUERTOS_MAX];   // pines de botones en cada puerto
+static uint32_t s_estable[HAL_GPIO_PUERTOS_MAX];   // 1 = pulsado, ya filtrado
+static uint32_t s_ct0[HAL_GPIO_PUERTOS_MAX];       // contador vertical: bit bajo
+static uint32_t s_ct1[HAL_GPIO_PUERTOS_MAX];       // contador vertical: bit alto
+static volatile uint32_t s_con_marca = 0;          // botones cuyo flanco ya fecho la ISR
+static uint8_t s_canal_escaneo = DRV_TIEMPO_SIN_CANAL;
+static volatile bool s_escaneando = false;
+static Tiempo_us_t s_periodo_escaneo_us = (Tiempo_us_t)DRV_BOTONES_ESCANEO_MS * 1000u;
+
+#ifdef DEBUG
+volatile uint32_t dbg_botones_escaneos = 0;
+#endif
+
+static void escaneo_arrancar(void) {
+    if (s_escaneando || s_canal_escaneo == DRV_TIEMPO_SIN_CANAL) return;
+    s_escaneando = true;
+    drv_tiempo_canal_arrancar_us(s_canal_escaneo, s_periodo_escaneo_us, true);
+}
+
+// Un cambio ya filtrado en el pin de un boton
+static void escaneo_notificar(uint8_t id_boton, bool pulsado, Tiempo_us_t ahora) {
+    if (pulsado) {
+        // Sin flanco por IRQ, la pulsacion empezo en la primera de las muestras iguales
+        if ((s_con_marca & (1u << id_boton)) == 0) {
+            s_marca_flanco[id_boton] = ahora - (Tiempo_us_t)(ESCANEO_MUESTRAS - 1) * s_periodo_escaneo_us;
+        }
+        s_con_marca &= ~(1u << id_boton);
+        s_stats[id_boton].pulsaciones++;
+        notificar(m_ev_confirmado, id_boton, s_marca_flanco[id_boton]);
+    } else {
+        notificar(m_ev_soltado, id_boton, ahora);
+    }
+}
+
+// Escaneo periodico (modo IRQ, desde el canal de drv_tiempo)
+static void escaneo_cb(uint32_t id, uint32_t aux) {
+    (void)id;
+    (void)aux;
+    Tiempo_us_t ahora = drv_tiempo_actual_us();
+    bool en_reposo = true;
+
+#ifdef DEBUG
+    dbg_botones_escaneos++;
+#endif
+
+    for (uint8_t p = 0; p < HAL_GPIO_PUERTOS_MAX; p++) {
+        if (s_mascara[p] == 0) continue;
+
+        // Una lectura para todos los botones del puerto (pulsado = nivel bajo, como la FSM)
+        uint32_t pulsado = ~hal_gpio_leer_puerto(p) & s_mascara[p];
+        uint32_t delta = pulsado ^ s_estable[p];
+
+        // Los pines que coinciden con su estado estable vuelven a 0; el resto cuenta 1,2,3,0
+        s_ct1[p] = (s_ct1[p] ^ s_ct0[p]) & delta;
+        s_ct0[p] = ~s_ct0[p] & delta;
+        uint32_t cambio = delta & ~(s_ct0[p] | s_ct1[p]);
+        s_estable[p] ^= cambio;
+
+        if (cambio) {
+            for (uint8_t i = 0; i < NUM_BOTONES; i++) {
+                uint32_t m = 1u << HAL_GPIO_BIT(s_pins_botones[i]);
+                if (HAL_GPIO_PUERTO(s_pins_botones[i]) == p && (cambio & m)) {
+                    escaneo_notificar(i, (s_estable[p] & m) != 0, ahora);
+                }
+            }
+        }
+        if (s_estable[p] | s_ct0[p] | s_ct1[p]) en_reposo = false;
+    }
+
+#if !defined(DRV_BOTONES_SONDEO)
+    if (en_reposo) {
+        // Nada pulsado ni a medio filtrar: parar y esperar al siguiente flanco.
+        // Los rebotes del soltado ya pasaron (hicieron falta 4 muestras iguales)
+        drv_tiempo_canal_parar(s_canal_escaneo);
+        s_escaneando = false;
+        s_con_marca = 0;
+        for (uint8_t i = 0; i < NUM_BOTONES; i++) {
+            hal_ext_int_limpiar_pendiente(i);
+            hal_ext_int_habilitar(i);
+        }
+    }
+#else
+    (void)en_reposo;    // sin flancos que lo despierten, el sondeo no para nunca
+#endif
+}
+#endif /* DRV_BOTONES_ESCANEO */
+
+void drv_botones_escaneo_periodo_ms(uint32_t periodo_ms) {
+#if defined(DRV_BOTONES_ESCANEO)
+    if (periodo_ms == 0) return;
+    s_periodo_escaneo_us = (Tiempo_us_t)periodo_ms * 1000u;
+    if (s_escaneando) {
+        drv_tiempo_canal_arrancar_us(s_canal_escaneo, s_periodo_escaneo_us, true);
+    }
+#else
+    (void)periodo_ms;
+#endif
+}
+
+#if !defined(DRV_BOTONES_SONDEO)
 
 // Callback que se ejecuta desde la ISR (Interrupcion Hardware)
 static void drv_cb(uint8_t id_boton) {
     // deshabilitamos interrupcion para que los rebotes no disparen la ISR constantemente
     hal_ext_int_deshabilitar(id_boton);
+    Tiempo_us_t marca = marcar_flanco(id_boton);
+
+#if defined(DRV_BOTONES_ESCANEO)
+    // El escaneo filtra y confirma; la pulsacion saldra con esta marca
+    (void)marca;
+    s_con_marca |= (1u << id_boton);
+    escaneo_arrancar();
+#else
+    rebote_medir(id_boton, marca, 0);
+
+    // Notificamos a la FSM (evento interno del driver, la app solo ve la pulsacion
+    // confirmada). La logica real se procesara en drv_botones_actualizar (nivel usuario)
+    notificar(m_ev_retardo, DRV_BOTONES_AUX_FLANCO | id_boton, marca);
+#endif
+}
+
+#endif /* !DRV_BOTONES_SONDEO */
+
+void drv_botones_encolar_con_marca(void(*funcion_encolar_ts)(uint32_t, uint32_t, Tiempo_us_t)) {
+    drv_botones_encolar_ts = funcion_encolar_ts;
+}
 
-    // Notificamos al gestor de eventos que ha ocurrido algo
-    // La logica real se procesara en drv_botones_actualizar (nivel usuario)
-    drv_botones_isr_callback(ev_PULSAR_BOTON, id_boton);
+Tiempo_us_t drv_botones_marca_pulsacion(uint8_t id_boton) {
+    if (id_boton >= NUM_BOTONES) return 0;
+    return s_marca_flanco[id_boton];
+}
+
+bool drv_botones_estadisticas(uint8_t id_boton, drv_botones_stats_t *stats) {
+    if (id_boton >= NUM_BOTONES || stats == NULL) return false;
+    *stats = s_stats[id_boton];
+    return true;
 }
 
 void drv_botones_iniciar (void(*funcion_callback_app)(uint32_t, uint32_t), 
@@ -66,36 +389,104 @@ void drv_botones_iniciar (void(*funcion_callback_app)(uint32_t, uint32_t),
     m_ev_soltado = ev_soltar;     
     m_ev_retardo = ev_tiempo;    
     
-    // Inicializar estados
+#if defined(DRV_BOTONES_ESCANEO)
+    // Un unico canal hardware para todos los botones; la FSM y sus alarmas no se usan
+    for (int i = 0; i < NUM_BOTONES; i++) {
+        s_mascara[HAL_GPIO_PUERTO(s_pins_botones[i])] |= 1u << HAL_GPIO_BIT(s_pins_botones[i]);
+    }
+    s_canal_escaneo = drv_tiempo_canal_reservar(escaneo_cb, 0, 0);
+#else
+    // Inicializar estados; las ventanas empiezan en el maximo y bajan con las medidas
     for (int i = 0; i < NUM_BOTONES; i++) {
         s_estado_botones[i] = e_esperando;
+        s_trp_ms[i] = TRP_MS;
+        s_trd_ms[i] = TRD_MS;
+        s_pico_trp_ms[i] = TRP_MS - REBOTE_MARGEN_MS;
+        s_pico_trd_ms[i] = TRD_MS - REBOTE_MARGEN_MS;
+        s_stats[i].trp_ms = TRP_MS;
+        s_stats[i].trd_ms = TRD_MS;
     }
+    s_canal_rebote = drv_tiempo_canal_reservar(rebote_cb, 0, 0);
     
     // Suscribir la FSM a los eventos del sistema
-    // ev_pulsar: viene de la ISR (inicio de pulsacion)
-    // ev_tiempo: viene de las alarmas (timeouts de rebotes)
-    rt_GE_suscribir(ev_pulsar, 0, drv_botones_actualizar);
+    // ev_tiempo: viene de la ISR (flanco, con DRV_BOTONES_AUX_FLANCO) y de las
+    // alarmas (timeouts de rebotes). ev_pulsar solo lo emite el driver, ya confirmado
     rt_GE_suscribir(ev_tiempo, 0, drv_botones_actualizar);
+#endif
 
     // Configurar hardware
+#if defined(DRV_BOTONES_SONDEO)
+    // Sin hal_ext_int: los pines se configuran aqui y se muestrean siempre
+    for (int i = 0; i < NUM_BOTONES; i++) {
+        hal_gpio_entrada(s_pins_botones[i], BUTTON_PULL);
+    }
+    escaneo_arrancar();
+#else
+    // Antes de iniciar: la ISR tomaria el LATCH del arranque por un flanco nuevo
+    s_despertar = hal_ext_int_despertar();
     hal_ext_int_iniciar(drv_cb);
     for (int i = 0; i < NUM_BOTONES; i++) {
+        // El que siga pulsado dispara la ISR al poner el SENSE: va por el camino normal
+        if (hal_gpio_leer(s_pins_botones[i]) == 0) s_despertar &= ~(1u << i);
         hal_ext_int_habilitar(i);
     }
+#endif
+}
+
+bool drv_botones_despiertan(void) {
+#if defined(DRV_BOTONES_SONDEO)
+    return false;
+#else
+    return true;
+#endif
+}
+
+uint32_t drv_botones_despertar(void) {
+    uint32_t botones = s_despertar;
+    Tiempo_us_t ahora = drv_tiempo_actual_us();
+
+    s_despertar = 0;
+    for (uint8_t i = 0; i < NUM_BOTONES; i++) {
+        if (!(botones & (1u << i))) continue;
+        s_marca_flanco[i] = ahora;
+        s_stats[i].pulsaciones++;
+        notificar(m_ev_confirmado, i, ahora);
+        drv_botones_isr_callback(m_ev_soltado, i);
+    }
+    return botones;
+}
+
+#if defined(DRV_BOTONES_ESCANEO)
+// Con el motor de escaneo no hay FSM: los eventos salen ya filtrados del canal
+void drv_botones_actualizar (EVENTO_T evento, uint32_t auxiliar){
+    (void)evento;
+    (void)auxiliar;
 }
+#else
+static void fsm_timeout(uint8_t button_id);
 
 // Maquina de Estados Principal
 void drv_botones_actualizar (EVENTO_T evento, uint32_t auxiliar){
     
+    // Muestreo agrupado: una sola alarma de grupo trae la mascara de botones a revisar
+    if (evento == m_ev_retardo && (auxiliar & SVC_ALARMA_AUX_GRUPO)) {
+        for (uint8_t i = 0; i < NUM_BOTONES; i++) {
+            if (auxiliar & (1u << i)) {
+                fsm_timeout(i);
+            }
+        }
+        return;
+    }
+
     uint8_t button_id = (uint8_t)auxiliar; 
     if (button_id >= NUM_BOTONES) return; 
 
-    // Caso 1: Evento de pulsacion inicial (desde ISR)
-    if (evento == ev_PULSAR_BOTON) {
+    // Caso 1: Evento de pulsacion inicial (flanco desde la ISR)
+    if (auxiliar & DRV_BOTONES_AUX_FLANCO) {
         if (s_estado_botones[button_id] == e_esperando) {
             // La IRQ ya se deshabilito en la ISR.
             // Programamos alarma para esperar a que la señal se estabilice (TRP)
-            uint32_t m_alarma_flags_trp = svc_alarma_codificar(false, TRP_MS, button_id);
+            uint32_t m_alarma_flags_trp = svc_alarma_codificar(false, s_trp_ms[button_id], button_id);
             svc_alarma_activar(m_alarma_flags_trp, m_ev_retardo, button_id);
             
             s_estado_botones[button_id] = e_rebotes;
@@ -104,24 +495,42 @@ void drv_botones_actualizar (EVENTO_T evento, uint32_t auxiliar){
     }
     
     // Caso 2: Eventos de temporizacion (timeouts de alarmas)
+    fsm_timeout(button_id);
+}
+
+// Transiciones por vencimiento de alarma (Trp, Tep, Trd) de un boton
+static void fsm_timeout(uint8_t button_id) {
     switch (s_estado_botones[button_id]) {
         
-        case e_rebotes: 
+        case e_rebotes: {
+            // Aun rebotando: la ventana se alarga sola (nunca mas alla de TRP_MS)
+            if (!rebote_asentado(button_id, TRP_MS)) break;
+
+            uint32_t espera_ms = drv_tiempo_us_a_ms(drv_tiempo_actual_us() - s_marca_flanco[button_id]);
+            s_trp_ms[button_id] = rebote_adaptar(button_id, &s_pico_trp_ms[button_id], TRP_MIN_MS, TRP_MS);
+            s_stats[button_id].trp_ms = s_trp_ms[button_id];
+
             // Ha pasado el tiempo de rebote inicial.
             // Leemos el pin para ver si sigue pulsado (Nivel Bajo = Activo)
             if (hal_gpio_leer(s_pins_botones[button_id]) == 0) { 
                 
-                // Confirmado: Es una pulsacion real y estable
-                drv_botones_isr_callback(m_ev_confirmado, button_id); 
+                // Confirmado: Es una pulsacion real y estable. Sale con el instante
+                // del primer flanco, no con el de ahora (TRP + alarma + cola despues)
+                s_stats[button_id].pulsaciones++;
+                if (espera_ms < TRP_MS) s_stats[button_id].ahorro_ms += TRP_MS - espera_ms;
+                notificar(m_ev_confirmado, button_id, s_marca_flanco[button_id]);
                 
-                // Pasamos a modo muestreo periodico para detectar cuando se suelta
+                // Pasamos a modo muestreo periodico para detectar cuando se suelta.
+                // Las alarmas TEP van en grupo: los botones pulsados a la vez se
+                // muestrean con un unico evento
                 uint32_t m_alarma_flags_tep = svc_alarma_codificar(true, TEP_MS, button_id);
-                svc_alarma_activar(m_alarma_flags_tep, m_ev_retardo, button_id);
+                svc_alarma_activar_grupo(m_alarma_flags_tep, m_ev_retardo, button_id, TEP_HOLGURA_MS);
                 
                 s_estado_botones[button_id] = e_muestreo;
                 
             } else {
                 // Falsa alarma (ruido): el boton ya no esta pulsado.
+                s_stats[button_id].falsas++;
                 // Avisamos que se ha soltado (por si la app esperaba algo)
                 drv_botones_isr_callback(m_ev_soltado, button_id); 
 
@@ -131,6 +540,7 @@ void drv_botones_actualizar (EVENTO_T evento, uint32_t auxiliar){
                 s_estado_botones[button_id] = e_esperando;
             }
             break;
+        }
             
         case e_muestreo: 
             // Comprobamos periodicamente si se ha soltado
@@ -144,8 +554,10 @@ void drv_botones_actualizar (EVENTO_T evento, uint32_t auxiliar){
                 svc_alarma_activar(0, m_ev_retardo, button_id);
                 
                 // 3. Esperar tiempo de seguridad (TRD) antes de reactivar IRQ
-                // Esto evita que los rebotes al soltar disparen una nueva pulsacion
-                uint32_t m_alarma_flags_trd = svc_alarma_codificar(false, TRD_MS, button_id);
+                // Esto evita que los rebotes al soltar disparen una nueva pulsacion.
+                // El rebote del soltado tambien se mide (empieza, como mucho, un TEP antes)
+                rebote_medir(button_id, drv_tiempo_actual_us(), 1);
+                uint32_t m_alarma_flags_trd = svc_alarma_codificar(false, s_trd_ms[button_id], button_id);
                 svc_alarma_activar(m_alarma_flags_trd, m_ev_retardo, button_id);
                 
                 s_estado_botones[button_id] = e_salida;
@@ -153,6 +565,10 @@ void drv_botones_actualizar (EVENTO_T evento, uint32_t auxiliar){
             break;
             
         case e_salida: 
+            if (!rebote_asentado(button_id, TRD_MS)) break;
+            s_trd_ms[button_id] = rebote_adaptar(button_id, &s_pico_trd_ms[button_id], TRD_MIN_MS, TRD_MS);
+            s_stats[button_id].trd_ms = s_trd_ms[button_id];
+
             // Ha pasado el tiempo de seguridad final.
             // Limpiamos flags pendientes y rehabilitamos la interrupcion
             hal_ext_int_limpiar_pendiente(button_id);
@@ -167,3 +583,4 @@ void drv_botones_actualizar (EVENTO_T evento, uint32_t auxiliar){
             break;
     }
 }
+#endif /* DRV_BOTONES_ESCANEO */
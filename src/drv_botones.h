@@ -20,9 +20,86 @@
  *
  * @param funcion_callback_app Puntero a la función para encolar eventos (ej. rt_FIFO_encolar).
  * @param ev1_pulsar          Evento a encolar cuando se confirma una pulsación (ev_PULSAR_BOTON).
+ *                            Es el único evento de pulsación que ve la app: el flanco
+ *                            bruto de la ISR viaja por ev2_tiempo con DRV_BOTONES_AUX_FLANCO.
  * @param ev2_tiempo          Evento usado internamente por la FSM para las alarmas (ev_BOTON_TIMER).
  */
 void drv_botones_iniciar(void(*funcion_callback_app)(uint32_t, uint32_t), EVENTO_T ev_pulsar, EVENTO_T ev_soltar,EVENTO_T ev2_tiempo); // <--- NUEVO ARGUMENTOEVENTO_T ev_tiempo);
+/**
+ * @brief Registra una función de encolado que acepta la marca de tiempo (ej. rt_FIFO_encolar_ts).
+ *
+ * Con ella el evento de flanco sale de la ISR con el instante del flanco: el capturado
+ * por hardware donde la placa puede (hal_ext_int_marca_flanco), en vez del de encolado.
+ * Sin registrar, se usa funcion_callback_app y la FIFO pone la hora de la ISR.
+ */
+void drv_botones_encolar_con_marca(void(*funcion_encolar_ts)(uint32_t, uint32_t, Tiempo_us_t));
+
+/* Marca en auxData del evento de flanco que la ISR envia a la FSM por ev_tiempo */
+#define DRV_BOTONES_AUX_FLANCO 0x40000000u
+
+/**
+ * @brief Instante (us) del primer flanco de la última pulsación de un botón.
+ *
+ * La pulsación confirmada (ev_pulsar) llega tras el filtrado TRP, pero se fecha con
+ * este instante: la app debe medir reacciones con él y no con drv_tiempo_actual_us()
+ * al tratar el evento, que incluye el rebote, la alarma y la cola.
+ * Es válido desde la ISR del flanco hasta la siguiente pulsación de ese botón.
+ */
+Tiempo_us_t drv_botones_marca_pulsacion(uint8_t id_boton);
+
+/**
+ * @brief Notifica la pulsación que arrancó la placa desde apagado.
+ *
+ * drv_botones_iniciar recoge las líneas que despertaron (hal_ext_int_despertar). Las
+ * que siguen pulsadas entran por la ISR al habilitarse, como cualquier otra; las ya
+ * soltadas se encolan aquí como ev_pulsar + ev_soltar con el instante de ahora.
+ * Llamar una vez tras iniciar el resto del sistema y solo si el arranque fue por un
+ * botón (HAL_CONSUMO_ARRANQUE_DESPERTAR): si no, el LATCH era de otra historia.
+ *
+ * @return Máscara de botones notificados.
+ */
+uint32_t drv_botones_despertar(void);
+
+/**
+ * @brief true si una pulsación saca a la CPU de drv_consumo_dormir.
+ *
+ * Con DRV_BOTONES_SONDEO no: sin líneas EINT/GPIOTE nadie mira los botones mientras
+ * se duerme y no habría forma de volver. Entonces no hay que llamar a dormir.
+ */
+bool drv_botones_despiertan(void);
+
+/* Estadísticas de antirrebote de un botón (ventanas autoajustadas de la FSM) */
+typedef struct {
+    uint32_t pulsaciones;       // pulsaciones confirmadas
+    uint32_t falsas;            // flancos descartados en TRP (ruido)
+    uint32_t flancos;           // cambios de nivel medidos durante los rebotes
+    uint32_t extensiones;       // ventanas alargadas porque el pin seguía rebotando
+    uint32_t ahorro_ms;         // latencia de confirmación ahorrada frente a TRP fijo
+    uint16_t rebote_ultimo_ms;  // asentamiento de la última medida
+    uint16_t rebote_max_ms;     // peor asentamiento medido
+    uint16_t trp_ms;            // ventana TRP en uso
+    uint16_t trd_ms;            // ventana TRD en uso
+} drv_botones_stats_t;
+
+/**
+ * @brief Copia las estadísticas de antirrebote de un botón.
+ *
+ * Con la FSM, TRP/TRD de cada botón siguen el rebote medido (pico + margen, entre
+ * un mínimo y los valores fijos de siempre como máximo). Con el motor de escaneo
+ * solo se cuentan las pulsaciones.
+ *
+ * @return false si el botón no existe.
+ */
+bool drv_botones_estadisticas(uint8_t id_boton, drv_botones_stats_t *stats);
+
+/**
+ * @brief Cambia el periodo de muestreo del motor de escaneo (DRV_BOTONES_ESCANEO o
+ * DRV_BOTONES_SONDEO). El filtrado pide 4 muestras iguales, así que el retardo de
+ * confirmación es ~3 periodos. Si ya está escaneando se aplica al momento.
+ * Con la FSM (sin escaneo) no hace nada.
+ */
+void drv_botones_escaneo_periodo_ms(uint32_t periodo_ms);
+
 /**
  * @brief Función de actualización (callback) para la máquina de estados de los botones.
  *
@@ -5,34 +5,142 @@
 #include "drv_consumo.h"
 #include "hal_consumo.h"
 #include "drv_monitor.h"
+#include "drv_tiempo.h"
+#include "drv_SC.h"
 #include <stdbool.h>
 
+#ifdef DEBUG
+#include "board.h"
+// --- VARIABLES GLOBALES DE DEPURACIÓN (Sin static, con volatile) ---
+volatile uint32_t dbg_consumo_dormidas = 0;
+volatile uint32_t dbg_consumo_dormido_ms = 0;       // duración del último sueño profundo
+volatile uint32_t dbg_consumo_despertar_us = 0;     // de volver a ejecutar a estar de vuelta en el despachador
+volatile uint32_t dbg_consumo_despertar_max_us = 0;
+volatile uint32_t dbg_consumo_causa_arranque = 0;   // HAL_CONSUMO_ARRANQUE_*
+// Residencia por nivel de reposo (hal_consumo_nivel_t): tiempo acumulado y entradas
+volatile uint32_t dbg_consumo_nivel_us[HAL_CONSUMO_NIVELES] = {0};
+volatile uint32_t dbg_consumo_nivel_veces[HAL_CONSUMO_NIVELES] = {0};
+volatile uint32_t dbg_consumo_nivel_limitado = 0;   // reposos más ligeros por un límite
+// Coste de cada nivel según hal_consumo_coste (en nRF, PROFUNDO medido al iniciar)
+volatile uint32_t dbg_consumo_equilibrio_us[HAL_CONSUMO_NIVELES] = {0};
+volatile uint32_t dbg_consumo_latencia_us[HAL_CONSUMO_NIVELES] = {0};
+#endif
+
 static bool s_iniciado = false;
 static uint32_t s_monitor = 0;
+static uint32_t s_causa_arranque = 0;
+static hal_consumo_coste_t s_coste[HAL_CONSUMO_NIVELES];
+
+typedef struct {
+    bool (*ocupado)(void);
+    hal_consumo_nivel_t nivel_max;
+} limite_t;
+static limite_t s_limites[DRV_CONSUMO_LIMITES];
+static uint8_t s_num_limites = 0;
 
 //bool drv_consumo_iniciar(uint32_t mon_wait, uint32) 
 bool drv_consumo_iniciar(uint32_t mon_id) {
     hal_consumo_iniciar();
+    // El registro de causa acumula entre resets: se lee una vez y se guarda
+    s_causa_arranque = hal_consumo_causa_arranque();
+#ifdef DEBUG
+    dbg_consumo_causa_arranque = s_causa_arranque;
+#endif
+    for (uint32_t n = 0; n < HAL_CONSUMO_NIVELES; n++) {
+        hal_consumo_coste((hal_consumo_nivel_t)n, &s_coste[n]);
+#ifdef DEBUG
+        dbg_consumo_equilibrio_us[n] = s_coste[n].equilibrio_us;
+        dbg_consumo_latencia_us[n] = s_coste[n].latencia_us;
+#endif
+    }
+    // Quien pidió la alta resolución cuenta con sus marcas y su disparo: no se apaga
+    drv_consumo_limitar(drv_tiempo_alta_resolucion_pedida, HAL_CONSUMO_ESPERAR);
 		s_monitor = mon_id;
     s_iniciado = true;
     return true;
 }
 
+uint32_t drv_consumo_causa_arranque(void) {
+    return s_causa_arranque;
+}
+
 void drv_consumo_esperar(void) {
     if (!s_iniciado) return;
 		drv_monitor_desmarcar(s_monitor);
 		//drv_monitor_desmarcar(s_monitor_esperar);
+    drv_SC_medida_pausar();     // se puede dormir dentro de una sección (DEBUG)
     hal_consumo_esperar();
+    drv_SC_medida_reanudar();
 		drv_monitor_marcar(s_monitor);
 		//drv_monitor_marcar(s_monitor_esperar);
 }
 
+bool drv_consumo_limitar(bool (*ocupado)(void), hal_consumo_nivel_t nivel_max) {
+    if (ocupado == NULL || s_num_limites >= DRV_CONSUMO_LIMITES) return false;
+    s_limites[s_num_limites].ocupado = ocupado;
+    s_limites[s_num_limites].nivel_max = nivel_max;
+    s_num_limites++;
+    return true;
+}
+
+// Nivel más profundo que cabe en el hueco hasta el próximo vencimiento
+static hal_consumo_nivel_t nivel_elegir(void) {
+    Tiempo_us_t proximo = drv_tiempo_proximo_us();
+    Tiempo_us_t ahora = drv_tiempo_actual_us();
+    Tiempo_us_t resto = (proximo > ahora) ? proximo - ahora : 0;
+
+    uint32_t nivel = HAL_CONSUMO_NIVELES - 1u;
+    for (uint8_t i = 0; i < s_num_limites; i++) {
+        if (s_limites[i].nivel_max < nivel && s_limites[i].ocupado()) {
+            nivel = s_limites[i].nivel_max;
+#ifdef DEBUG
+            dbg_consumo_nivel_limitado++;
+#endif
+        }
+    }
+    while (nivel > HAL_CONSUMO_ESPERAR) {
+        const hal_consumo_coste_t *c = &s_coste[nivel];
+        if (c->disponible && resto >= (Tiempo_us_t)c->equilibrio_us + c->latencia_us) break;
+        nivel--;
+    }
+    return (hal_consumo_nivel_t)nivel;
+}
+
+void drv_consumo_reposar(void) {
+    if (!s_iniciado) return;
+    hal_consumo_nivel_t nivel = nivel_elegir();
+#ifdef DEBUG
+    Tiempo_us_t inicio = drv_tiempo_actual_us();
+#endif
+		drv_monitor_desmarcar(s_monitor);
+    if (nivel == HAL_CONSUMO_PROFUNDO) hal_consumo_esperar_profundo();
+    else hal_consumo_esperar();
+		drv_monitor_marcar(s_monitor);
+#ifdef DEBUG
+    dbg_consumo_nivel_us[nivel] += (uint32_t)(drv_tiempo_actual_us() - inicio);
+    dbg_consumo_nivel_veces[nivel]++;
+#endif
+}
+
 void drv_consumo_dormir(void) {
     if (!s_iniciado) return;
 		drv_monitor_desmarcar(s_monitor);
     //drv_monitor_desmarcar(s_monitor_dormir);
-    hal_consumo_dormir();
+#ifdef DEBUG
+    Tiempo_ms_t inicio = drv_tiempo_actual_ms();
+#endif
+    // Vuelve con el estado intacto: nada de arrancar otra vez desde main()
+    uint32_t despierto = hal_consumo_dormir();
 		drv_monitor_marcar(s_monitor);
+#ifdef DEBUG
+    uint32_t us = (drv_tiempo_ciclos() - despierto) / CPU_CLOCK_MHZ;
+    dbg_consumo_despertar_us = us;
+    if (us > dbg_consumo_despertar_max_us) dbg_consumo_despertar_max_us = us;
+    dbg_consumo_dormido_ms = drv_tiempo_actual_ms() - inicio;
+    dbg_consumo_dormidas++;
+#else
+    (void)despierto;
+#endif
 		//Reset_handler();
 
     //drv_monitor_marcar(s_monitor_dormir);
@@ -8,6 +8,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include "hal_consumo.h"     // HAL_CONSUMO_ARRANQUE_*
 
 /** Inicializa el gestor de consumo. Devuelve true si OK. */
 bool drv_consumo_iniciar(uint32_t mon_id);
@@ -15,7 +16,23 @@ bool drv_consumo_iniciar(uint32_t mon_id);
 /** Entra en modo "esperar" (System ON sleep) hasta la prxima IRQ. */
 void drv_consumo_esperar(void);
 
-/** Entra en modo "dormir" (igual que esperar en esta versin). */
+/** Reposo en el hueco ocioso del despachador: elige el nivel ms profundo
+ *  (hal_consumo_nivel_t) cuyo equilibrio y latencia caben antes del prximo
+ *  vencimiento de drv_tiempo, dentro de lo que permitan los lmites registrados.
+ *  Vuelve con la prxima IRQ, como drv_consumo_esperar. */
+void drv_consumo_reposar(void);
+
+/** Registra un lmite: mientras ocupado() devuelva true no se reposa ms hondo
+ *  que nivel_max (p.ej. un perifrico que depende del reloj rpido). Se consulta
+ *  en cada reposo, sin IRQ deshabilitadas. false si no caben ms lmites. */
+#define DRV_CONSUMO_LIMITES 4
+bool drv_consumo_limitar(bool (*ocupado)(void), hal_consumo_nivel_t nivel_max);
+
+/** Entra en modo "dormir" (bajo consumo profundo conservando el estado) hasta que
+ *  un botn despierta; la pulsacin llega luego como cualquier otra. */
 void drv_consumo_dormir(void);
 
+/** Causa del arranque (mscara HAL_CONSUMO_ARRANQUE_*), leda en drv_consumo_iniciar. */
+uint32_t drv_consumo_causa_arranque(void);
+
 #endif /* DRV_CONSUMO_H */
@@ -0,0 +1,82 @@
+/* *****************************************************************************
+ * P.H.2025: Driver de la región de flash reservada
+ * Implementación independiente del hardware, delega en HAL.
+ */
+#include "drv_flash.h"
+#include "hal_flash.h"
+#include "board.h"
+
+#ifdef DEBUG
+#include "drv_tiempo.h"
+// --- VARIABLES GLOBALES DE DEPURACIÓN (Sin static, con volatile) ---
+volatile uint32_t dbg_flash_borrados = 0;
+volatile uint32_t dbg_flash_palabras = 0;
+volatile uint32_t dbg_flash_errores = 0;
+volatile uint32_t dbg_flash_bloqueo_max_us = 0;   // mayor tiempo con la CPU parada por el NVMC/IAP
+
+static void registrar_bloqueo(Tiempo_us_t inicio) {
+    uint32_t us = (uint32_t)(drv_tiempo_actual_us() - inicio);
+    if (us > dbg_flash_bloqueo_max_us) dbg_flash_bloqueo_max_us = us;
+}
+#endif
+
+static uint32_t pagina_dir(uint32_t pagina) {
+    return FLASH_ALMACEN_DIR + pagina * hal_flash_tam_pagina();
+}
+
+uint32_t drv_flash_paginas(void) {
+    return FLASH_ALMACEN_PAGINAS;
+}
+
+uint32_t drv_flash_tam_pagina(void) {
+    return hal_flash_tam_pagina();
+}
+
+const uint32_t *drv_flash_pagina(uint32_t pagina) {
+    return (const uint32_t *)pagina_dir(pagina);
+}
+
+bool drv_flash_borrar(uint32_t pagina) {
+    if (pagina >= FLASH_ALMACEN_PAGINAS) return false;
+
+    const uint32_t *p = drv_flash_pagina(pagina);
+    uint32_t palabras = hal_flash_tam_pagina() / 4;
+    uint32_t i = 0;
+    while (i < palabras && p[i] == 0xFFFFFFFFu) i++;
+    if (i == palabras) return true;
+
+#ifdef DEBUG
+    Tiempo_us_t inicio = drv_tiempo_actual_us();
+#endif
+    bool ok = hal_flash_borrar_pagina(pagina_dir(pagina));
+#ifdef DEBUG
+    registrar_bloqueo(inicio);
+    dbg_flash_borrados++;
+    if (!ok) dbg_flash_errores++;
+#endif
+    return ok;
+}
+
+bool drv_flash_escribir(uint32_t pagina, uint32_t offset, const uint32_t *datos, uint32_t num) {
+    if (pagina >= FLASH_ALMACEN_PAGINAS || (offset & 3u)) return false;
+    if (offset + num * 4 > hal_flash_tam_pagina()) return false;
+
+#ifdef DEBUG
+    Tiempo_us_t inicio = drv_tiempo_actual_us();
+#endif
+    bool ok = hal_flash_escribir(pagina_dir(pagina) + offset, datos, num);
+#ifdef DEBUG
+    registrar_bloqueo(inicio);
+    dbg_flash_palabras += num;
+#endif
+
+    // Verificación: un bit que no baja (palabra ya escrita, desgaste) se detecta aquí
+    const uint32_t *p = drv_flash_pagina(pagina) + offset / 4;
+    for (uint32_t i = 0; ok && i < num; i++) {
+        if (p[i] != datos[i]) ok = false;
+    }
+#ifdef DEBUG
+    if (!ok) dbg_flash_errores++;
+#endif
+    return ok;
+}
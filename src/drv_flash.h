@@ -0,0 +1,34 @@
+/* *****************************************************************************
+ * P.H.2025: Driver de la región de flash reservada para datos persistentes
+ * Interfaz independiente del hardware. La región (FLASH_ALMACEN_DIR, _PAGINAS)
+ * la define board.h y queda fuera de la zona de código del proyecto.
+ */
+#ifndef DRV_FLASH_H
+#define DRV_FLASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/** Número de páginas de la región reservada. */
+uint32_t drv_flash_paginas(void);
+
+/** Tamaño de página en bytes (4 KB nRF, 8 KB LPC). */
+uint32_t drv_flash_tam_pagina(void);
+
+/** Contenido de la página (lectura directa, la flash está mapeada en memoria). */
+const uint32_t *drv_flash_pagina(uint32_t pagina);
+
+/**
+ * Borra la página. Bloquea decenas o cientos de ms: solo fuera de partida / en reposo.
+ * Si la página ya está en blanco no la borra (no gasta un ciclo de borrado).
+ */
+bool drv_flash_borrar(uint32_t pagina);
+
+/**
+ * Programa num palabras en la página a partir del byte offset (múltiplo de 4) y
+ * comprueba lo escrito. Devuelve false si se sale de la página o no se lee lo escrito.
+ */
+bool drv_flash_escribir(uint32_t pagina, uint32_t offset, const uint32_t *datos, uint32_t num);
+
+#endif /* DRV_FLASH_H */
@@ -19,14 +19,34 @@
 
 #include "hal_gpio.h"
 #include "drv_leds.h"
+#include "drv_tiempo.h"
 #include "board.h"
 
 
 #if LEDS_NUMBER > 0
 	static const HAL_GPIO_PIN_T s_led_list[LEDS_NUMBER] = LEDS_LIST;
+
+/* Marco pendiente (el que se esta mostrando es el estado de los pines) */
+static volatile drv_leds_marco_t s_marco_siguiente = 0;
+static volatile bool s_marco_pendiente = false;
+static uint8_t s_canal_marco = DRV_TIEMPO_SIN_CANAL;
+static uint8_t s_disparo_marco = DRV_TIEMPO_SIN_DISPARO;
+static bool s_marco_hw = false;     /* el pendiente lo pone el disparo, no el canal */
 #endif
 
 /* Helpers ------------------------------------------------------------------ */
+#if LEDS_NUMBER > 0
+/* El disparo hardware no avisa: se mira su evento. Ya mostrado, se quita el enlace
+ * para que no vuelva a saltar a la vuelta del contador. */
+static bool marco_pendiente(void) {
+    if (s_marco_pendiente && s_marco_hw && drv_tiempo_disparo_saltado(s_disparo_marco)) {
+        hal_gpio_marco_cancelar();
+        s_marco_pendiente = false;
+    }
+    return s_marco_pendiente;
+}
+#endif
+
 static inline int led_id_valido(LED_id_t id) {
 #if LEDS_NUMBER > 0
     return (id >= 1 && id <= (LED_id_t)LEDS_NUMBER);
@@ -74,6 +94,7 @@ unsigned int drv_leds_iniciar(){
 int drv_led_establecer(LED_id_t id, LED_status_t estado) {
 #if LEDS_NUMBER > 0
     if (!led_id_valido(id)) return 0;
+    if (marco_pendiente()) drv_leds_marco_cancelar();   /* lo escrito a mano manda */
     hal_gpio_escribir(s_led_list[id-1], hw_level_from_status(estado));
     return 1;
 #else
@@ -107,4 +128,83 @@ int drv_led_conmutar(LED_id_t id) {
 #endif
 }
 
+/* Marcos -------------------------------------------------------------------- */
+
+#if LEDS_NUMBER > 0
+/* Niveles de los pines para un marco, en orden de s_led_list */
+static uint32_t marco_niveles(drv_leds_marco_t marco) {
+    uint32_t niveles = 0;
+    for (uint8_t i = 0; i < LEDS_NUMBER; i++) {
+        LED_status_t st = ((marco >> i) & 1u) ? LED_ON : LED_OFF;
+        niveles |= hw_level_from_status(st) << i;
+    }
+    return niveles;
+}
+
+/* IRQ del canal de tiempo: el marco entero, un acceso por puerto */
+static void marco_vencido(uint32_t id, uint32_t aux) {
+    (void)id; (void)aux;
+    if (!s_marco_pendiente) return;
+    uint32_t niveles = marco_niveles(s_marco_siguiente);
+    uint32_t mascara[HAL_GPIO_PUERTOS_MAX] = {0};
+    uint32_t valores[HAL_GPIO_PUERTOS_MAX] = {0};
+    for (uint8_t i = 0; i < LEDS_NUMBER; i++) {
+        uint8_t p = HAL_GPIO_PUERTO(s_led_list[i]);
+        mascara[p] |= 1u << HAL_GPIO_BIT(s_led_list[i]);
+        valores[p] |= ((niveles >> i) & 1u) << HAL_GPIO_BIT(s_led_list[i]);
+    }
+    for (uint8_t p = 0; p < HAL_GPIO_PUERTOS_MAX; p++) {
+        if (mascara[p]) hal_gpio_escribir_puerto(p, mascara[p], valores[p]);
+    }
+    s_marco_pendiente = false;
+}
+#endif
+
+bool drv_leds_marco_en(drv_leds_marco_t marco, Tiempo_us_t instante) {
+#if LEDS_NUMBER > 0
+    drv_leds_marco_cancelar();
+    s_marco_siguiente = marco;
+
+    /* Por hardware: comparador propio -> PPI -> GPIOTE */
+    if (s_disparo_marco == DRV_TIEMPO_SIN_DISPARO) s_disparo_marco = drv_tiempo_disparo_reservar();
+    if (drv_tiempo_disparo_us(s_disparo_marco, instante) &&
+        hal_gpio_marco_armar(s_disparo_marco, s_led_list, LEDS_NUMBER, marco_niveles(marco))) {
+        s_marco_hw = true;
+        s_marco_pendiente = true;   /* hasta que salte el comparador (marco_pendiente) */
+        return true;
+    }
+    s_marco_hw = false;
+
+    /* Por software: IRQ de un canal de tiempo de un solo disparo */
+    if (s_canal_marco == DRV_TIEMPO_SIN_CANAL) {
+        s_canal_marco = drv_tiempo_canal_reservar(marco_vencido, 0, 0);
+        if (s_canal_marco == DRV_TIEMPO_SIN_CANAL) return false;
+    }
+    Tiempo_us_t ahora = drv_tiempo_actual_us();
+    if (instante <= ahora) return false;
+    s_marco_pendiente = true;
+    drv_tiempo_canal_arrancar_us(s_canal_marco, instante - ahora, false);
+    return true;
+#else
+    (void)marco; (void)instante;
+    return false;
+#endif
+}
+
+bool drv_leds_marco_pendiente(void) {
+#if LEDS_NUMBER > 0
+    return marco_pendiente();
+#else
+    return false;
+#endif
+}
+
+void drv_leds_marco_cancelar(void) {
+#if LEDS_NUMBER > 0
+    s_marco_pendiente = false;
+    hal_gpio_marco_cancelar();
+    if (s_canal_marco != DRV_TIEMPO_SIN_CANAL) drv_tiempo_canal_parar(s_canal_marco);
+#endif
+}
+
 //otras???
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include "drv_tiempo.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -72,6 +74,30 @@ int drv_led_estado(LED_id_t id, LED_status_t *out_estado);
  */
 int drv_led_conmutar(LED_id_t id);
 
+/* ---- Marcos precargados (doble buffer) ----
+ * El siguiente estado de todos los LEDs se compone con antelacion y cambia de golpe
+ * en un instante exacto, sin depender de cuando el GE despache el evento:
+ *   - nRF: disparo de TIMER4 -> PPI -> tareas SET/CLR de GPIOTE (sin CPU).
+ *   - Resto: IRQ de un canal de drv_tiempo que escribe el puerto de una vez.
+ * Escribir un LED con drv_led_establecer/conmutar anula el marco pendiente. */
+typedef uint32_t drv_leds_marco_t;              /* bit (id-1) a 1 = LED id encendido */
+#define DRV_LEDS_MARCO_LED(id)  ((drv_leds_marco_t)1u << ((id) - 1))
+
+/**
+ * @brief Programa el marco para que se muestre en 'instante' (base de drv_tiempo_actual_us).
+ *
+ * Sustituye al marco pendiente, si lo hay.
+ * @return false si no se ha podido programar (instante pasado o sin temporizador):
+ *         entonces no se escribe nada y el llamante debe pintar a mano.
+ */
+bool drv_leds_marco_en(drv_leds_marco_t marco, Tiempo_us_t instante);
+
+/** Anula el marco pendiente (los LEDs se quedan como estan) */
+void drv_leds_marco_cancelar(void);
+
+/** true mientras el marco programado no se ha mostrado todavia */
+bool drv_leds_marco_pendiente(void);
+
 #if 0
 /* ---- Funciones opcionales de alto nivel ---- */
 
@@ -6,25 +6,273 @@
 
 #include "drv_sonido.h"
 #include "hal_sonido.h"
+#include "drv_tiempo.h"
+#include "drv_SC.h"
+#include "drv_consumo.h"
+#include "svc_q16.h"
+
+/* Cada tono nuevo invalida la parada programada del anterior */
+static volatile uint32_t s_tono_actual = 0;
+
+/* Aviso de fin de secuencia */
+static void (*s_cb)(uint32_t, uint32_t) = NULL;
+static EVENTO_T s_ev_fin = ev_VOID;
+static uint32_t s_id_secuencia;
+
+/* Disparo hardware del click (drv_tiempo_disparo_reservar) */
+static uint8_t s_disparo_click = DRV_TIEMPO_SIN_DISPARO;
+
+/* Secuencia por software (HAL sin secuenciador) */
+static const drv_sonido_nota_t *s_notas;
+static uint8_t s_num_notas;
+static uint8_t s_nota;
+
+/* Voces PCM: posición y paso en Q16 sobre la muestra de origen */
+typedef struct {
+    const int8_t *muestras;
+    uint32_t num_q16;           // num_muestras << 16
+    uint32_t pos_q16;
+    uint32_t paso_q16;          // muestras de origen por muestra de salida
+    uint32_t restantes;         // muestras de salida que le quedan
+    uint32_t id;
+} voz_t;
+
+static voz_t s_voces[DRV_SONIDO_VOCES];
+static volatile uint8_t s_voces_activas = 0;     // bit v = voz v sonando
+static volatile bool s_pcm_en_marcha = false;    // el HAL está pidiendo bloques
+static uint32_t s_pcm_muestreo_hz = 0;           // 0 = sin salida PCM
+
+#ifdef DEBUG
+static uint32_t s_bloque_us = 0;
+volatile uint32_t dbg_sonido_bloques = 0;
+volatile uint32_t dbg_sonido_relleno_us = 0;      // último bloque
+volatile uint32_t dbg_sonido_relleno_max_us = 0;
+volatile uint32_t dbg_sonido_carga_max_pm = 0;    // relleno_max_us / duración de un bloque, en ‰
+#endif
 
 /**
  * @brief Inicializa el driver de sonido.
  * Configura el pin del buzzer como salida mediante el HAL.
  */
-void drv_sonido_iniciar(void) {
+void drv_sonido_iniciar(void(*funcion_callback_app)(uint32_t, uint32_t), EVENTO_T ev_fin) {
+    s_cb = funcion_callback_app;
+    s_ev_fin = ev_fin;
     hal_sonido_iniciar();
+    s_disparo_click = drv_tiempo_disparo_reservar();
+    s_pcm_muestreo_hz = hal_sonido_pcm(NULL);
+    // Con el HFXO apagado el PWM pasaría al oscilador RC y desafinaría
+    drv_consumo_limitar(drv_sonido_activo, HAL_CONSUMO_ESPERAR);
+#ifdef DEBUG
+    if (s_pcm_muestreo_hz) s_bloque_us = (HAL_SONIDO_PCM_BLOQUE * 1000000u) / s_pcm_muestreo_hz;
+#endif
+}
+
+// Un tono o secuencia sustituye a las voces PCM sin avisar de su fin
+static void pcm_callar(void) {
+    s_voces_activas = 0;
+    s_pcm_en_marcha = false;
 }
 
 /**
  * @brief Genera un tono con la frecuencia y duración especificadas.
  * 
- * NOTA: Esta implementación es BLOQUEANTE (detiene la ejecución durante 'ms').
- * Se usa así por simplicidad. Dado que los sonidos son cortos (<500ms) 
- * y el Watchdog suele ser de 1s o más, es seguro en este contexto.
+ * Bloquea durante 'ms' pero con la CPU dormida (drv_tiempo_esperar_ms) y
+ * atendiendo el resto de IRQ. Con el WDT de 1s, reservar para tonos cortos.
  *
  * @param frecuencia_hz Frecuencia del tono en Hz (ej. 1000 para 1kHz).
  * @param duracion_ms Duración del tono en milisegundos.
  */
 void drv_sonido_tocar(uint32_t frecuencia_hz, uint32_t duracion_ms) {
-    hal_sonido_tocar(frecuencia_hz, duracion_ms);
+    s_tono_actual++;
+    pcm_callar();
+    hal_sonido_iniciar_tono(frecuencia_hz);
+    drv_tiempo_esperar_ms(duracion_ms);
+    hal_sonido_parar();
+}
+
+// Fin de un tono asíncrono (modo IRQ): solo para si no lo ha sustituido otro
+static void tono_vencido(uint32_t id, uint32_t tono) {
+    (void)id;
+    if (tono == s_tono_actual) hal_sonido_parar();
+}
+
+bool drv_sonido_tocar_async(uint32_t frecuencia_hz, uint32_t duracion_ms) {
+    uint32_t tono = ++s_tono_actual;
+    pcm_callar();
+    hal_sonido_iniciar_tono(frecuencia_hz);
+    if (!drv_tiempo_esperar_async_ms(duracion_ms, tono_vencido, 0, tono)) {
+        hal_sonido_parar();  // sin canal: mejor callar que sonar para siempre
+        return false;
+    }
+    return true;
+}
+
+bool drv_sonido_activo(void) {
+    return hal_sonido_activo();
+}
+
+void drv_sonido_parar(void) {
+    s_tono_actual++;
+    pcm_callar();
+    hal_sonido_click_cancelar();
+    hal_sonido_parar();
+}
+
+bool drv_sonido_click(Tiempo_us_t instante, uint16_t frecuencia_hz, uint16_t duracion_ms) {
+    // Enlace fuera mientras cambia el comparador; se vuelve a poner con el disparo nuevo
+    hal_sonido_click_cancelar();
+    if (!drv_tiempo_disparo_us(s_disparo_click, instante)) return false;
+    return hal_sonido_click_armar(s_disparo_click, frecuencia_hz, duracion_ms);
+}
+
+// Fin de secuencia (IRQ del PWM o del canal de drv_tiempo)
+static void secuencia_fin(void) {
+    if (s_cb != NULL && s_ev_fin != ev_VOID) s_cb(s_ev_fin, s_id_secuencia);
+}
+
+// Modo software: arranca la nota s_nota y programa su fin
+static void secuencia_paso(uint32_t id, uint32_t tono);
+
+static bool secuencia_nota(uint32_t tono) {
+    const drv_sonido_nota_t *nota = &s_notas[s_nota++];
+    hal_sonido_iniciar_tono(nota->frecuencia_hz);   // 0 = silencio
+    uint32_t ms = (nota->duracion_ms > 0) ? nota->duracion_ms : 1;
+    if (!drv_tiempo_esperar_async_ms(ms, secuencia_paso, 0, tono)) {
+        hal_sonido_parar();
+        return false;
+    }
+    return true;
+}
+
+// Modo software: vence la nota en curso
+static void secuencia_paso(uint32_t id, uint32_t tono) {
+    (void)id;
+    if (tono != s_tono_actual) return;   // sustituida por otro tono/secuencia
+
+    if (s_nota >= s_num_notas) {
+        hal_sonido_parar();
+        secuencia_fin();
+    } else if (!secuencia_nota(tono)) {
+        secuencia_fin();                 // sin canal: se da por acabada
+    }
+}
+
+bool drv_sonido_secuencia(const drv_sonido_nota_t *notas, uint8_t num_notas, uint32_t id) {
+    uint32_t tono = ++s_tono_actual;    // anula la parada de un tono async pendiente
+    pcm_callar();
+
+    // El id cambia con la anterior ya sustituida (no avisa) y la IRQ del PWM bloqueada:
+    // ni el fin de la anterior sale con este id ni el de esta con el anterior
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    bool hw = hal_sonido_secuencia(notas, num_notas, secuencia_fin);
+    s_id_secuencia = id;
+    drv_SC_salir_enable_irq(sc);
+    if (hw) return true;
+
+    // Sin secuenciador hardware: una espera async por nota
+    s_notas = notas;
+    s_num_notas = num_notas;
+    s_nota = 0;
+    if (num_notas == 0) {
+        secuencia_fin();
+        return true;
+    }
+    if (!secuencia_nota(tono)) {
+        secuencia_fin();                // sin canal: quien espera ev_fin no se queda colgado
+        return false;
+    }
+    return true;
+}
+
+/* Mezcla un bloque (IRQ del PWM). Acumula cada voz sobre el propio bloque como int16
+ * y al final lo pasa a sin signo: el coste es n * voces activas, acotado. */
+static bool pcm_rellenar(uint16_t *bloque, uint32_t n) {
+#ifdef DEBUG
+    Tiempo_us_t t0 = drv_tiempo_actual_us();
+#endif
+    int16_t *mezcla = (int16_t *)bloque;
+    uint8_t terminadas = 0;
+
+    for (uint32_t i = 0; i < n; i++) mezcla[i] = 0;
+
+    for (uint8_t v = 0; v < DRV_SONIDO_VOCES; v++) {
+        if (!(s_voces_activas & (1u << v))) continue;
+        voz_t *voz = &s_voces[v];
+        uint32_t cuantas = (voz->restantes < n) ? voz->restantes : n;
+
+        for (uint32_t i = 0; i < cuantas; i++) {
+            mezcla[i] += voz->muestras[voz->pos_q16 >> 16];
+            voz->pos_q16 += voz->paso_q16;
+            if (voz->pos_q16 >= voz->num_q16) voz->pos_q16 -= voz->num_q16;  // tabla: vuelta
+        }
+        voz->restantes -= cuantas;
+        if (voz->restantes == 0) {
+            terminadas |= (uint8_t)(1u << v);
+            if (s_cb != NULL && s_ev_fin != ev_VOID) s_cb(s_ev_fin, voz->id);
+        }
+    }
+    s_voces_activas &= (uint8_t)~terminadas;   // IRQ: el GE no la interrumpe a medias
+
+    // 2 voces de -128..127 suman -256..254: /2 y centrado en el reposo del PWM
+    for (uint32_t i = 0; i < n; i++) {
+        bloque[i] = (uint16_t)((HAL_SONIDO_PCM_MAX + 1u) / 2u + (mezcla[i] >> 1));
+    }
+
+#ifdef DEBUG
+    dbg_sonido_bloques++;
+    dbg_sonido_relleno_us = (uint32_t)(drv_tiempo_actual_us() - t0);
+    if (dbg_sonido_relleno_us > dbg_sonido_relleno_max_us) {
+        dbg_sonido_relleno_max_us = dbg_sonido_relleno_us;
+        dbg_sonido_carga_max_pm = (s_bloque_us > 0) ? dbg_sonido_relleno_max_us * 1000u / s_bloque_us : 0;
+    }
+#endif
+
+    if (s_voces_activas == 0) {
+        s_pcm_en_marcha = false;    // este bloque es el último
+        return false;
+    }
+    return true;
+}
+
+// Prepara la voz y arranca la salida PCM si estaba parada
+static bool pcm_voz(uint8_t voz, const int8_t *muestras, uint16_t num_muestras,
+                    q16_t paso, uint32_t restantes, uint32_t id) {
+    if (s_pcm_muestreo_hz == 0 || voz >= DRV_SONIDO_VOCES || muestras == NULL ||
+        num_muestras == 0 || paso <= 0 || restantes == 0) return false;
+
+    s_tono_actual++;    // anula la parada de un tono async o una secuencia software
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    s_voces[voz].muestras = muestras;
+    s_voces[voz].num_q16 = (uint32_t)num_muestras << 16;
+    s_voces[voz].pos_q16 = 0;
+    s_voces[voz].paso_q16 = (uint32_t)paso;
+    s_voces[voz].restantes = restantes;
+    s_voces[voz].id = id;
+    s_voces_activas |= (uint8_t)(1u << voz);
+    bool arrancar = !s_pcm_en_marcha;
+    s_pcm_en_marcha = true;
+    drv_SC_salir_enable_irq(sc);
+
+    if (arrancar) hal_sonido_pcm(pcm_rellenar);
+    return true;
+}
+
+bool drv_sonido_pcm(uint8_t voz, const int8_t *muestras, uint16_t num_muestras,
+                    uint16_t muestreo_hz, uint32_t id) {
+    if (s_pcm_muestreo_hz == 0) return false;
+    q16_t paso = q16_ratio(muestreo_hz, s_pcm_muestreo_hz);
+    if (paso <= 0) return false;
+    // Muestras de salida hasta pasar de la última de origen: ceil(num / paso)
+    uint32_t restantes = (((uint32_t)num_muestras << 16) - 1u) / (uint32_t)paso + 1u;
+    return pcm_voz(voz, muestras, num_muestras, paso, restantes, id);
+}
+
+bool drv_sonido_onda(uint8_t voz, const int8_t *tabla, uint16_t num_muestras,
+                     uint16_t frecuencia_hz, uint16_t duracion_ms, uint32_t id) {
+    if (s_pcm_muestreo_hz == 0 || num_muestras == 0) return false;
+    if ((uint32_t)frecuencia_hz * 2u >= s_pcm_muestreo_hz) return false;   // > fs/2: aliasing
+    // Un periodo de la tabla por ciclo: paso = f * num / fs (menos de media tabla)
+    q16_t paso = q16_ratio((uint32_t)frecuencia_hz * num_muestras, s_pcm_muestreo_hz);
+    uint32_t restantes = ((uint32_t)duracion_ms * s_pcm_muestreo_hz) / 1000u;
+    return pcm_voz(voz, tabla, num_muestras, paso, restantes, id);
 }
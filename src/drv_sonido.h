@@ -2,22 +2,104 @@
 #define DRV_SONIDO_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "rt_evento_t.h"
+#include "hal_sonido.h"
+
+/* Nota de una secuencia: {frecuencia_hz (0 = silencio), duracion_ms, ciclo_pct (0 = 50%)} */
+typedef hal_sonido_nota_t drv_sonido_nota_t;
 
 /**
  * @brief Inicializa el driver de sonido.
  * Configura el pin del buzzer como salida.
+ *
+ * @param funcion_callback_app Función para notificar el fin de una secuencia (ej. rt_FIFO_encolar).
+ * @param ev_fin Evento de fin de secuencia (auxData = id de drv_sonido_secuencia).
+ *               ev_VOID si no se quiere aviso.
  */
-void drv_sonido_iniciar(void);
+void drv_sonido_iniciar(void(*funcion_callback_app)(uint32_t, uint32_t), EVENTO_T ev_fin);
 
 /**
  * @brief Genera un tono con la frecuencia y duración especificadas.
- * * NOTA: Esta implementación es BLOQUEANTE (detiene la ejecución durante 'ms').
- * Se usa así por simplicidad. Dado que los sonidos son cortos (<500ms) 
- * y el Watchdog suele ser de 1s o más, es seguro en este contexto.
+ * * NOTA: Es BLOQUEANTE durante 'ms', aunque la CPU duerme mientras tanto
+ * (drv_tiempo_esperar_ms). Dado que los sonidos son cortos (<500ms) 
+ * y el Watchdog es de 1s, es seguro en este contexto.
  *
  * @param frecuencia_hz Frecuencia del tono en Hz (ej. 1000 para 1kHz).
  * @param duracion_ms Duración del tono en milisegundos.
  */
 void drv_sonido_tocar(uint32_t frecuencia_hz, uint32_t duracion_ms);
 
+/**
+ * @brief Arranca el tono y vuelve enseguida; se para solo a los 'ms'.
+ *
+ * La parada la dispara un canal de drv_tiempo (drv_tiempo_esperar_async_ms).
+ * Un tono posterior sustituye al actual. Devuelve false (y no suena) si no
+ * queda canal de temporización libre.
+ */
+bool drv_sonido_tocar_async(uint32_t frecuencia_hz, uint32_t duracion_ms);
+
+/**
+ * @brief Corta el tono o la secuencia en curso (sin evento de fin).
+ */
+void drv_sonido_parar(void);
+
+/**
+ * @brief Toca una lista de notas y vuelve enseguida.
+ *
+ * Las notas no se copian: el array debe seguir vivo hasta el final (const en flash).
+ * En nRF la temporización la lleva el PWM con EasyDMA (una IRQ por nota); en placas
+ * sin secuenciador hardware, un canal de drv_tiempo por nota.
+ * Al acabar se notifica ev_fin con auxData = id. Una secuencia o tono posterior
+ * sustituye a la actual y esta ya no avisa.
+ *
+ * @return false (y no suena) si no queda canal de temporización en modo software;
+ *         ev_fin se notifica igualmente.
+ */
+bool drv_sonido_secuencia(const drv_sonido_nota_t *notas, uint8_t num_notas, uint32_t id);
+
+/**
+ * @brief Click de metrónomo que empieza exactamente en 'instante' (base de drv_tiempo_actual_us).
+ *
+ * El arranque lo hace el hardware (comparador de tiempo -> PPI -> PWM), así que no
+ * depende de la carga del bucle. Hay que volver a llamarla para cada pulso. Otro
+ * sonido tiene prioridad: si sigue sonando en el instante el click se pierde, pero
+ * si acaba antes el click vuelve a quedar armado (p.ej. el tono de un acierto).
+ *
+ * @return false si no se ha podido programar (placa sin PPI, instante pasado o,
+ *         con HAL_TIEMPO_RTC, fuera de alta resolución).
+ */
+bool drv_sonido_click(Tiempo_us_t instante, uint16_t frecuencia_hz, uint16_t duracion_ms);
+
+/**
+ * @brief true mientras suena algo. Mientras tanto el reposo no apaga el reloj
+ * rápido (drv_consumo_limitar): el tono del PWM sale de él.
+ */
+bool drv_sonido_activo(void);
+
+/* --- Muestras PCM y tablas de onda ---
+ * Muestras de 8 bits con signo en flash, mezcladas por software en DRV_SONIDO_VOCES
+ * voces y enviadas al PWM por DMA en bloques (solo placas con hal_sonido_pcm). El
+ * coste es un bucle fijo por bloque en la IRQ del PWM; en DEBUG se mide en
+ * dbg_sonido_relleno_max_us y dbg_sonido_carga_max_pm (‰ del tiempo de un bloque). */
+#define DRV_SONIDO_VOCES 2
+
+/**
+ * @brief Toca una muestra PCM una vez en la voz indicada (sustituye lo que sonara en ella).
+ *
+ * @param muestreo_hz Frecuencia a la que se grabó (se remuestrea a la de salida).
+ * @return false si la placa no tiene salida PCM o la voz no existe.
+ *         Al acabar se notifica ev_fin con auxData = id.
+ */
+bool drv_sonido_pcm(uint8_t voz, const int8_t *muestras, uint16_t num_muestras,
+                    uint16_t muestreo_hz, uint32_t id);
+
+/**
+ * @brief Toca una tabla de onda (un periodo de num_muestras) a frecuencia_hz durante duracion_ms.
+ *
+ * @return Igual que drv_sonido_pcm.
+ */
+bool drv_sonido_onda(uint8_t voz, const int8_t *tabla, uint16_t num_muestras,
+                     uint16_t frecuencia_hz, uint16_t duracion_ms, uint32_t id);
+
 #endif /* DRV_SONIDO_H */
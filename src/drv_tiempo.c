@@ -5,61 +5,161 @@
 
 #include "drv_tiempo.h"
 #include "hal_tiempo.h"
+#include "drv_SC.h"
+#include "drv_consumo.h"
+#include "board.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
+/* Division por constante sin divisor hardware (el ARM7 no lo tiene y la de 64 bits
+ * es una llamada a libreria de cientos de ciclos):
+ *   n / d == mulhi64(n, M)   con M = floor((2^64-1)/d) + 1
+ * exacta para n < 2^64/(d-1): con d = 1000 (us -> ms) son mas de 500 anos de uptime.
+ * Si d es potencia de 2 basta un desplazamiento. */
+#define RECIPROCO_64(d)      (UINT64_MAX / (uint64_t)(d) + 1u)
+#define ES_POTENCIA_DE_2(d)  (((d) & ((d) - 1u)) == 0u)
+
+typedef struct {
+    uint64_t reciproco;      /* 0 si se usa el desplazamiento */
+    uint8_t  desplazamiento;
+} divisor_t;
+
 /* Estado interno */
 static hal_tiempo_info_t s_hal_info;
 static bool s_iniciado = false;
-static uint32_t s_parametro = 0;
-static void(*s_funcion)(uint32_t, uint32_t) = NULL; // Corregido tipo
+static divisor_t s_div_us;   /* ticks -> us, calculado en drv_tiempo_iniciar */
+#ifdef TIMER_TICKS_PER_US
+static bool s_div_constante = false; /* la placa coincide con el HAL: divisor en compilacion */
+#endif
+static uint32_t s_peticiones_alta = 0;  /* anidamiento de drv_tiempo_alta_resolucion */
+static uint8_t s_disparos_reservados = 0;
+
+/* Canales hardware: cada uno con su callback y su evento */
+typedef struct {
+    bool reservado;
+    bool liberar_al_vencer;  /* espera asincrona: el canal se devuelve al disparar */
+    void (*funcion)(uint32_t, uint32_t);
+    uint32_t ID_evento;
+    uint32_t auxData;
+} canal_t;
+static canal_t s_canales[HAL_TIEMPO_CANALES];
+static volatile uint32_t s_esperas_vencidas = 0;  /* bit por canal de espera bloqueante */
+
+/* Parte alta (bits 64..127) del producto de 64x64, con multiplicaciones de 32x32 (UMULL) */
+static inline uint64_t mulhi64(uint64_t a, uint64_t b) {
+    uint32_t a_lo = (uint32_t)a, a_hi = (uint32_t)(a >> 32);
+    uint32_t b_lo = (uint32_t)b, b_hi = (uint32_t)(b >> 32);
+    uint64_t ll = (uint64_t)a_lo * b_lo;
+    uint64_t lh = (uint64_t)a_lo * b_hi;
+    uint64_t hl = (uint64_t)a_hi * b_lo;
+    uint64_t hh = (uint64_t)a_hi * b_hi;
+    uint64_t medio = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    return hh + (lh >> 32) + (hl >> 32) + (medio >> 32);
+}
+
+static void divisor_preparar(divisor_t *div, uint32_t d) {
+    div->reciproco = 0;
+    div->desplazamiento = 0;
+    if (ES_POTENCIA_DE_2(d)) {
+        while ((1u << div->desplazamiento) < d) div->desplazamiento++;
+    } else {
+        div->reciproco = RECIPROCO_64(d);   /* unica division de 64 bits, solo al iniciar */
+    }
+}
+
+static inline uint64_t ticks_a_us(uint64_t ticks) {
+#ifdef TIMER_TICKS_PER_US
+    if (s_div_constante) {
+        /* Constantes de compilacion: el compilador deja un desplazamiento o el producto */
+        return ES_POTENCIA_DE_2(TIMER_TICKS_PER_US) ? ticks / TIMER_TICKS_PER_US
+                                                     : mulhi64(ticks, RECIPROCO_64(TIMER_TICKS_PER_US));
+    }
+#endif
+    if (s_div_us.reciproco == 0) return ticks >> s_div_us.desplazamiento;
+    return mulhi64(ticks, s_div_us.reciproco);
+}
 
 /**
  * inicializa el reloj y empieza a contar
  */
 bool drv_tiempo_iniciar(void) {
     hal_tiempo_iniciar_tick(&s_hal_info);
+    if (s_hal_info.ticks_per_us == 0) return false;
+
+    divisor_preparar(&s_div_us, s_hal_info.ticks_per_us);
+#ifdef TIMER_TICKS_PER_US
+    // Si la placa no coincide con lo que informa el HAL, se usa el divisor calculado
+    s_div_constante = (s_hal_info.ticks_per_us == TIMER_TICKS_PER_US);
+#endif
     s_iniciado = true;
     return true;
 }
 
+/**
+ * convierte ticks del contador libre (base de hal_tiempo_actual_tick64) a microsegundos
+ */
+Tiempo_us_t drv_tiempo_ticks_a_us(uint64_t ticks) {
+    if (!s_iniciado) return (Tiempo_us_t)0;
+    return (Tiempo_us_t)ticks_a_us(ticks);
+}
+
 /**
  * tiempo desde que se inicio el temporizador en microsegundos
  */
 Tiempo_us_t drv_tiempo_actual_us(void) {
-    uint64_t ticks;
-    uint64_t us;
-
     if (!s_iniciado) return (Tiempo_us_t)0;
-
-    ticks = hal_tiempo_actual_tick64();
-
-    if (s_hal_info.ticks_per_us == 0) return (Tiempo_us_t)0;
-
-    us = ticks / (uint64_t)s_hal_info.ticks_per_us;
-    return (Tiempo_us_t)us;
+    return (Tiempo_us_t)ticks_a_us(hal_tiempo_actual_tick64());
 }
 
 /**
  * tiempo desde que se inicio el temporizador en milisegundos
  */
 Tiempo_ms_t drv_tiempo_actual_ms(void) {
-    Tiempo_us_t us = drv_tiempo_actual_us();
-    return (Tiempo_ms_t)(us / 1000u);
+    return drv_tiempo_us_a_ms(drv_tiempo_actual_us());
+}
+
+Tiempo_ms_t drv_tiempo_us_a_ms(Tiempo_us_t us) {
+    return (Tiempo_ms_t)mulhi64(us, RECIPROCO_64(1000u));
+}
+
+// Vencimiento de una espera bloqueante (modo IRQ): ID_evento es el canal
+static void espera_vencida(uint32_t canal, uint32_t aux) {
+    (void)aux;
+    s_esperas_vencidas |= (1u << canal);
 }
 
 /**
  * retardo: esperar un cierto tiempo en milisegundos
+ * Bloquea durmiendo (drv_consumo_esperar) hasta la comparacion de un canal de
+ * un solo disparo; las demas IRQ se siguen atendiendo. No llamar con las IRQ
+ * deshabilitadas ni desde una ISR.
  */
 void drv_tiempo_esperar_ms(Tiempo_ms_t ms) {
-    Tiempo_ms_t inicio, ahora;
-    inicio = drv_tiempo_actual_ms();
-    Tiempo_ms_t deadline = inicio + ms;
+    if (!s_iniciado || ms == 0) return;
 
-    do {
-        ahora = drv_tiempo_actual_ms();
-    } while ((Tiempo_ms_t)(ahora - deadline) > (Tiempo_ms_t)0 && ahora != deadline);
+    uint8_t canal = drv_tiempo_canal_reservar(espera_vencida, 0, 0);
+    if (canal == DRV_TIEMPO_SIN_CANAL) {
+        // Sin canal libre: espera activa como ultimo recurso
+        Tiempo_us_t fin = drv_tiempo_actual_us() + (Tiempo_us_t)ms * 1000u;
+        while (drv_tiempo_actual_us() < fin) {}
+        return;
+    }
+    s_canales[canal].ID_evento = canal;
+    s_esperas_vencidas &= ~(1u << canal);
+    drv_tiempo_canal_arrancar_us(canal, (Tiempo_us_t)ms * 1000u, false);
+
+    while (1) {
+        // Comprobar y dormir sin que la IRQ se cuele entre medias (WFI despierta igual)
+        uint32_t sc = drv_SC_entrar_disable_irq();
+        if (s_esperas_vencidas & (1u << canal)) {
+            drv_SC_salir_enable_irq(sc);
+            break;
+        }
+        drv_consumo_esperar();
+        drv_SC_salir_enable_irq(sc);
+    }
+    drv_tiempo_canal_liberar(canal);
 }
 
 /**
@@ -67,40 +167,175 @@ void drv_tiempo_esperar_ms(Tiempo_ms_t ms) {
  */
 Tiempo_ms_t drv_tiempo_esperar_hasta_ms(Tiempo_ms_t deadline_ms) {
     Tiempo_ms_t ahora = drv_tiempo_actual_ms();
+    int32_t resto = (int32_t)(deadline_ms - ahora);
 
-    if ((Tiempo_ms_t)(ahora - deadline_ms) <= (Tiempo_ms_t)0) {
-       // Ya paso
-    }
-
-    while (1) {
+    if (resto > 0) {
+        drv_tiempo_esperar_ms((Tiempo_ms_t)resto);
         ahora = drv_tiempo_actual_ms();
-        if (ahora >= deadline_ms) break;
     }
     return ahora;
 }
 
+bool drv_tiempo_esperar_async_ms(Tiempo_ms_t ms, void(*funcion_callback_app)(), uint32_t ID_evento, uint32_t auxData) {
+    uint8_t canal = drv_tiempo_canal_reservar(funcion_callback_app, ID_evento, auxData);
+    if (canal == DRV_TIEMPO_SIN_CANAL) return false;
+
+    s_canales[canal].liberar_al_vencer = true;
+    drv_tiempo_canal_arrancar_us(canal, (Tiempo_us_t)ms * 1000u, false);
+    return true;
+}
+
 // --- CORRECCIÓN IMPORTANTE AQUÍ ---
 // Definimos el tipo de puntero compatible con rt_FIFO_encolar (2 argumentos)
 typedef void (*f_callback_fifo_t)(uint32_t, uint32_t);
 
-void drv_funcion_callback_app(){
-    // Casteamos para asegurar que se pasan los argumentos correctos
-    if (s_funcion != NULL) {
-        // Pasamos el ID del evento (s_parametro) y 0 como dato auxiliar
-        // Esto evita que rt_FIFO lea basura de la memoria
-        ((f_callback_fifo_t)s_funcion)(s_parametro, 0);
+// Callback del HAL (modo IRQ): pasa el evento y el aux propios del canal
+static void drv_canal_callback(uint8_t canal) {
+    canal_t *c = &s_canales[canal];
+    if (c->funcion != NULL) {
+        c->funcion(c->ID_evento, c->auxData);
     }
+    if (c->liberar_al_vencer) {
+        // El HAL ya lo desarmo (un solo disparo): solo queda devolverlo
+        c->liberar_al_vencer = false;
+        c->funcion = NULL;
+        c->reservado = false;
+    }
+}
+
+uint8_t drv_tiempo_canal_reservar(void(*funcion_callback_app)(), uint32_t ID_evento, uint32_t auxData) {
+    uint8_t canal = DRV_TIEMPO_SIN_CANAL;
+    if (!s_iniciado || funcion_callback_app == NULL) return canal;
+
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    for (uint8_t i = 0; i < HAL_TIEMPO_CANALES; i++) {
+        if (!s_canales[i].reservado) {
+            s_canales[i].reservado = true;
+            s_canales[i].liberar_al_vencer = false;
+            s_canales[i].funcion = (f_callback_fifo_t)funcion_callback_app;
+            s_canales[i].ID_evento = ID_evento;
+            s_canales[i].auxData = auxData;
+            canal = i;
+            break;
+        }
+    }
+    drv_SC_salir_enable_irq(sc);
+    return canal;
+}
+
+void drv_tiempo_canal_arrancar_us(uint8_t canal, Tiempo_us_t periodo_us, bool periodico) {
+    if (canal >= HAL_TIEMPO_CANALES || !s_canales[canal].reservado) return;
+
+    // Convertir us -> ticks (el comparador es de 32 bits)
+    uint64_t periodo_en_tick = (uint64_t)periodo_us * s_hal_info.ticks_per_us;
+    if (periodo_en_tick > 0xFFFFFFFFu) periodo_en_tick = 0xFFFFFFFFu;
+
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    hal_tiempo_canal_tick(canal, (uint32_t)periodo_en_tick, periodico, drv_canal_callback);
+    drv_SC_salir_enable_irq(sc);
+}
+
+void drv_tiempo_canal_parar(uint8_t canal) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    hal_tiempo_canal_enable(canal, false);
+    drv_SC_salir_enable_irq(sc);
+}
+
+void drv_tiempo_canal_liberar(uint8_t canal) {
+    if (canal >= HAL_TIEMPO_CANALES) return;
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    hal_tiempo_canal_tick(canal, 0, false, NULL);
+    s_canales[canal].reservado = false;
+    s_canales[canal].liberar_al_vencer = false;
+    s_canales[canal].funcion = NULL;
+    drv_SC_salir_enable_irq(sc);
 }
 
 void drv_tiempo_periodico_ms(Tiempo_ms_t ms, void(*funcion_callback_app)(), uint32_t ID_evento) {
     if (!s_iniciado || funcion_callback_app == NULL) return;
 
-    // Convertir ms -> ticks
-    uint32_t periodo_en_tick = (uint32_t)ms * (s_hal_info.ticks_per_us * 1000u);
-    s_parametro = ID_evento;
-    // Guardamos la función casteada
-    s_funcion = (void(*)(uint32_t, uint32_t))funcion_callback_app;
+    // El mismo (callback, evento) reprograma su canal; otro llamante obtiene uno nuevo
+    uint8_t canal = DRV_TIEMPO_SIN_CANAL;
+    for (uint8_t i = 0; i < HAL_TIEMPO_CANALES; i++) {
+        if (s_canales[i].reservado && s_canales[i].ID_evento == ID_evento &&
+            s_canales[i].funcion == (f_callback_fifo_t)funcion_callback_app) {
+            canal = i;
+        }
+    }
+
+    if (ms == 0) {
+        if (canal != DRV_TIEMPO_SIN_CANAL) drv_tiempo_canal_liberar(canal);
+        return;
+    }
+    if (canal == DRV_TIEMPO_SIN_CANAL) {
+        canal = drv_tiempo_canal_reservar(funcion_callback_app, ID_evento, 0);
+        if (canal == DRV_TIEMPO_SIN_CANAL) return;
+    }
+    drv_tiempo_canal_arrancar_us(canal, (Tiempo_us_t)ms * 1000u, true);
+}
+
+void drv_tiempo_alarma_us(Tiempo_us_t deadline_us, void (*funcion_callback)(void)) {
+    if (!s_iniciado || funcion_callback == NULL) return;
+
+    // Convertir us -> ticks absolutos del contador libre
+    uint64_t deadline_tick = (uint64_t)deadline_us * (uint64_t)s_hal_info.ticks_per_us;
+    hal_tiempo_alarma_tick(deadline_tick, funcion_callback);
+}
+
+void drv_tiempo_alarma_cancelar(void) {
+    hal_tiempo_alarma_cancelar();
+}
+
+uint8_t drv_tiempo_disparo_reservar(void) {
+    if (s_disparos_reservados >= HAL_TIEMPO_DISPAROS) return DRV_TIEMPO_SIN_DISPARO;
+    return s_disparos_reservados++;
+}
+
+bool drv_tiempo_disparo_us(uint8_t disparo, Tiempo_us_t deadline_us) {
+    if (!s_iniciado || disparo >= s_disparos_reservados) return false;
+    // Entre leer la cuenta y escribir el comparador no puede pasar el margen del HAL
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    bool ok = hal_tiempo_disparo_tick(disparo, (uint64_t)deadline_us * (uint64_t)s_hal_info.ticks_per_us);
+    drv_SC_salir_enable_irq(sc);
+    return ok;
+}
+
+bool drv_tiempo_disparo_saltado(uint8_t disparo) {
+    if (disparo >= s_disparos_reservados) return false;
+    return hal_tiempo_disparo_saltado(disparo);
+}
+
+void drv_tiempo_alta_resolucion(bool activar) {
+    uint32_t sc;
+    if (activar) {
+        if (s_peticiones_alta++ > 0) return;
+        // El oscilador se espera fuera: cientos de us con las IRQ del runtime bloqueadas
+        hal_tiempo_reloj_rapido(true);
+        // El HAL cambia de reloj y re-arma la alarma: no puede colarse su IRQ
+        sc = drv_SC_entrar_disable_irq();
+        hal_tiempo_alta_resolucion(true);
+        drv_SC_salir_enable_irq(sc);
+    } else if (s_peticiones_alta > 0) {
+        if (--s_peticiones_alta > 0) return;
+        sc = drv_SC_entrar_disable_irq();
+        hal_tiempo_alta_resolucion(false);
+        drv_SC_salir_enable_irq(sc);
+        hal_tiempo_reloj_rapido(false);
+    }
+}
+
+bool drv_tiempo_alta_resolucion_pedida(void) {
+    return s_peticiones_alta > 0;
+}
+
+Tiempo_us_t drv_tiempo_proximo_us(void) {
+    if (!s_iniciado) return DRV_TIEMPO_NUNCA;
+    uint64_t tick = hal_tiempo_proximo_tick();
+    if (tick == HAL_TIEMPO_NUNCA) return DRV_TIEMPO_NUNCA;
+    return (Tiempo_us_t)ticks_a_us(tick);
+}
 
-    // Registrar el callback de aplicación directamente en el HAL
-    hal_tiempo_reloj_periodico_tick(periodo_en_tick, drv_funcion_callback_app);
+uint32_t drv_tiempo_ciclos(void) {
+    return hal_tiempo_ciclos();
 }
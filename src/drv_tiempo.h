@@ -20,10 +20,86 @@ bool drv_tiempo_iniciar(void);
 Tiempo_us_t drv_tiempo_actual_us(void);
 Tiempo_ms_t drv_tiempo_actual_ms(void);
 
-/* Esperas bloqueantes */
+/* us a ms (instante o intervalo) con el reciproco de 1000: sin la division de 64
+ * bits por software (__aeabi_uldivmod) en los Cortex-M/ARM7 */
+Tiempo_ms_t drv_tiempo_us_a_ms(Tiempo_us_t us);
+
+/* Ticks del contador libre (hal_tiempo_actual_tick64) a us, sin division */
+Tiempo_us_t drv_tiempo_ticks_a_us(uint64_t ticks);
+
+/* Esperas bloqueantes de bajo consumo: duermen hasta la comparacion de un canal
+ * hardware (las IRQ se siguen atendiendo). Solo para los pocos sitios que deben
+ * bloquear; no llamar desde una ISR ni con las IRQ deshabilitadas. */
 void drv_tiempo_esperar_ms(Tiempo_ms_t ms);
 
 /* Esperar hasta (deadline en ms). Devuelve el tiempo actual tras la espera. */
 Tiempo_ms_t drv_tiempo_esperar_hasta_ms(Tiempo_ms_t deadline_ms);
+
+/* Espera asincrona: vuelve enseguida y, pasados ms, llama en modo IRQ a
+ * funcion_callback_app(ID_evento, auxData) (p.ej. rt_FIFO_encolar), de modo que
+ * el que espera recibe un evento y la CPU duerme mientras tanto en el GE.
+ * Usa un canal hardware que se libera solo al vencer; false si no queda ninguno. */
+bool drv_tiempo_esperar_async_ms(Tiempo_ms_t ms, void(*funcion_callback_app)(), uint32_t ID_evento, uint32_t auxData);
+
+/* Periodico en ms sobre un canal propio: varios llamantes ya no se pisan.
+ * Repetir la llamada con el mismo (callback, evento) lo reprograma; ms = 0 lo libera. */
 void drv_tiempo_periodico_ms(Tiempo_ms_t ms, void(*funcion_callback_app)(), uint32_t ID_evento);
+
+/* --- Canales de temporizacion hardware (HAL_TIEMPO_CANALES) ---
+ * Cada canal llama en modo IRQ a funcion_callback_app(ID_evento, auxData),
+ * p.ej. rt_FIFO_encolar o una funcion del propio driver. */
+#define DRV_TIEMPO_SIN_CANAL 0xFFu
+
+/* Reserva un canal; devuelve su numero o DRV_TIEMPO_SIN_CANAL si no quedan */
+uint8_t drv_tiempo_canal_reservar(void(*funcion_callback_app)(), uint32_t ID_evento, uint32_t auxData);
+
+/* Arranca el canal: periodico, o un solo disparo a periodo_us de ahora.
+ * Llamarlo con el canal en marcha lo reprograma. */
+void drv_tiempo_canal_arrancar_us(uint8_t canal, Tiempo_us_t periodo_us, bool periodico);
+
+/* Para el canal sin liberarlo */
+void drv_tiempo_canal_parar(uint8_t canal);
+
+/* Para el canal y lo devuelve al conjunto libre */
+void drv_tiempo_canal_liberar(uint8_t canal);
+
+/* Alarma hardware de un solo disparo en el instante absoluto deadline_us
+ * (misma base que drv_tiempo_actual_us). El callback se ejecuta en modo IRQ.
+ * Solo hay una: programar otra sustituye a la anterior. */
+void drv_tiempo_alarma_us(Tiempo_us_t deadline_us, void (*funcion_callback)(void));
+void drv_tiempo_alarma_cancelar(void);
+
+/* Disparo hardware (sin IRQ) en el instante absoluto deadline_us, para que otro
+ * periferico arranque solo en ese momento (hal_tiempo_disparo_tick). Hay
+ * HAL_TIEMPO_DISPAROS: cada usuario reserva el suyo y lo pasa a su HAL para el PPI. */
+#define DRV_TIEMPO_SIN_DISPARO 0xFFu
+
+/* Reserva un disparo; devuelve su numero o DRV_TIEMPO_SIN_DISPARO si no quedan */
+uint8_t drv_tiempo_disparo_reservar(void);
+/* false si ya ha pasado o la placa no tiene disparo hardware */
+bool drv_tiempo_disparo_us(uint8_t disparo, Tiempo_us_t deadline_us);
+/* true si ya ha saltado desde que se programo */
+bool drv_tiempo_disparo_saltado(uint8_t disparo);
+
+/* Pide (true) o libera (false) resolucion sub-us en el contador libre.
+ * Admite anidamiento: se mantiene mientras haya alguna peticion sin liberar.
+ * En placas con base de baja frecuencia (nRF + HAL_TIEMPO_RTC) enciende el
+ * reloj rapido solo durante ese intervalo: su arranque (~360 us) se espera fuera
+ * de la seccion critica, que solo cubre el cambio de base. Desde el hilo del
+ * despachador, no desde IRQ. */
+void drv_tiempo_alta_resolucion(bool activar);
+
+/* true mientras quede alguna peticion de alta resolucion sin liberar. Quien la
+ * pidio cuenta con las marcas sub-us y el disparo hardware: el reposo no debe
+ * apagar el reloj rapido en ese intervalo (drv_consumo lo limita a ESPERAR). */
+bool drv_tiempo_alta_resolucion_pedida(void);
+
+/* Instante (us, misma base que drv_tiempo_actual_us) del proximo vencimiento
+ * programado: alarma o canal en marcha. DRV_TIEMPO_NUNCA si no hay ninguno. */
+#define DRV_TIEMPO_NUNCA  UINT64_MAX
+Tiempo_us_t drv_tiempo_proximo_us(void);
+
+/* Ciclos de CPU (CPU_CLOCK_MHZ por us, 32 bits con vuelta) para medir intervalos
+ * cortos: (fin - inicio) / CPU_CLOCK_MHZ = us. No cuenta con la CPU dormida en nRF. */
+uint32_t drv_tiempo_ciclos(void);
 #endif // DRV_TIEMPO_H
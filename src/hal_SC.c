@@ -1,18 +0,0 @@
-#include <stdbool.h>
-#include <stdint.h>
-#include <stddef.h>
-#include "hal_SC.h"
-
-
-void deshabilitar_irq(void){
-    // Deshabilita las interrupciones y devuelve el estado actual de la regin crtica
-    __disable_irq();
-		
-    
-}
-
-void habilitar_irq(void){
-    // Restaura el estado previo de las interrupciones
-    __enable_irq();
-    
-}
@@ -5,23 +5,41 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/* Prioridades de IRQ (0 = la más alta) en placas con prioridades enmascarables.
+ * Las ISR que comparten datos con el runtime (cola de eventos, alarmas, drivers)
+ * van en HAL_SC_PRIORIDAD_RUNTIME y quedan bloqueadas dentro de una sección crítica.
+ * Las de HAL_SC_PRIORIDAD_CRITICA siguen entrando: no pueden usar drv_SC ni nada
+ * que llame a la cola (p.ej. desbordes de la base de tiempo). */
+#define HAL_SC_PRIORIDAD_CRITICA  1u
+#define HAL_SC_PRIORIDAD_RUNTIME  3u
 
 /**
- * @brief Entra en una sección crítica y deshabilita las interrupciones.
+ * @brief Pone todas las IRQ en HAL_SC_PRIORIDAD_RUNTIME.
  *
- * Esta función anida llamadas, manteniendo las interrupciones deshabilitadas
- * hasta que la última llamada a drv_SC_salir_enable_irq se ejecute.
+ * Llamar antes de iniciar ningún periférico: cada HAL sube luego a
+ * HAL_SC_PRIORIDAD_CRITICA solo las suyas que no tocan el runtime.
+ */
+void hal_SC_iniciar(void);
+
+/**
+ * @brief Entra en una sección crítica y devuelve el estado de enmascarado previo.
  *
- * 
+ * nRF: BASEPRI sube (nunca baja) hasta HAL_SC_PRIORIDAD_RUNTIME.
+ * LPC: bit I del CPSR (deshabilita todas las IRQ).
  */
-void deshabilitar_irq(void);
+uint32_t hal_SC_entrar(void);
+
+/* Estado devuelto por hal_SC_entrar cuando no había nada enmascarado: esa es la
+ * sección más exterior (en las dos placas) */
+#define HAL_SC_ESTADO_LIBRE  0u
 
 /**
- * @brief Sale de una sección crítica y habilita las interrupciones.
+ * @brief Restaura el estado devuelto por su hal_SC_entrar.
  *
- * Si es la última salida anidada, las interrupciones se habilitan.
+ * Anidar no necesita contador: la sección interior restaura el enmascarado que
+ * ya tenía la exterior.
  */
-void habilitar_irq(void);
+void hal_SC_salir(uint32_t estado);
 
 
 #endif /* HAL_SC_H */
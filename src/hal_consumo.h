@@ -8,6 +8,14 @@
 #include <stdint.h>
 #include <stdbool.h>
 extern void switch_to_PLL();
+
+/* Causa del ltimo arranque (mscara de hal_consumo_causa_arranque) */
+#define HAL_CONSUMO_ARRANQUE_ENCENDIDO  (1u << 0)   // alimentacin (o la placa no lo distingue)
+#define HAL_CONSUMO_ARRANQUE_PIN        (1u << 1)   // pin de reset
+#define HAL_CONSUMO_ARRANQUE_PERRO      (1u << 2)   // watchdog
+#define HAL_CONSUMO_ARRANQUE_SOFTWARE   (1u << 3)   // reset pedido por software o bloqueo de la CPU
+#define HAL_CONSUMO_ARRANQUE_DESPERTAR  (1u << 4)   // un botn despert del apagado
+
 /**
  * Inicializa el subsistema de consumo (si procede).
  * Para nRF52 no es necesario configurar nada especial para WFI.
@@ -20,10 +28,56 @@ void hal_consumo_iniciar(void);
  */
 void hal_consumo_esperar(void);
 
+/* Niveles de reposo entre eventos, de menos a ms profundo. Todos vuelven con la
+ * prxima IRQ habilitada y el estado intacto (a diferencia de hal_consumo_dormir,
+ * no enmascaran nada: valen para los huecos entre alarmas). */
+typedef enum {
+    HAL_CONSUMO_ESPERAR = 0,   // WFI
+    HAL_CONSUMO_LENTO,         // WFI con el reloj rpido de alta resolucin apagado (nadie lo pide)
+    HAL_CONSUMO_PROFUNDO,      // lo anterior y la RAM sin uso apagada (hal_consumo_esperar_profundo)
+    HAL_CONSUMO_NIVELES
+} hal_consumo_nivel_t;
+
+/* Coste de entrar en un nivel */
+typedef struct {
+    bool disponible;
+    uint32_t equilibrio_us;    // hueco mnimo para que ahorre ms de lo que cuesta entrar y salir
+    uint32_t latencia_us;      // de la IRQ que despierta a volver a ejecutar con todo en marcha
+} hal_consumo_coste_t;
+
+/**
+ * Coste de cada nivel en esta placa (no cambia en ejecucin).
+ * nRF: LENTO solo con HAL_TIEMPO_RTC (sin TIMER1 de base no hay reloj rpido que
+ * apagar); el coste de PROFUNDO se mide al llamarla (drv_consumo_iniciar).
+ * LPC: solo ESPERAR.
+ */
+void hal_consumo_coste(hal_consumo_nivel_t nivel, hal_consumo_coste_t *coste);
+
+/**
+ * Como hal_consumo_esperar, pero con las secciones de RAM sin uso apagadas
+ * mientras tanto. Despierta cualquier IRQ habilitada. LPC: igual que esperar.
+ */
+void hal_consumo_esperar_profundo(void);
+
+/**
+ * Modo "dormir": bajo consumo profundo conservando RAM y registros; solo
+ * despiertan los botones. Vuelve al llamante con el estado intacto y la IRQ
+ * del botn que despert atendida (la pulsacin sigue su camino normal).
+ * nRF: System ON con las dems IRQ enmascaradas y la RAM sin uso apagada. Si pasan
+ * CONSUMO_APAGAR_TRAS_S (board.h) sin botones, entra en System OFF y no vuelve.
+ * LPC: Power-down (PCON.PD), despierta por EINT.
+ * Devuelve hal_tiempo_ciclos() al volver a ejecutar, para medir cunto tarda
+ * el software en estar otra vez disponible.
+ */
+uint32_t hal_consumo_dormir(void);
+
 /**
- * Modo "dormir": igual que esperar en esta versin (WFI).
- * En versiones futuras podra aadir medidas ms agresivas.
+ * Causa del ltimo arranque (HAL_CONSUMO_ARRANQUE_*). Lee y limpia el registro
+ * de la placa: llamar una sola vez, al iniciar.
+ * nRF: RESETREAS. Tras CONSUMO_APAGAR_TRAS_S dormido, hal_consumo_dormir pasa a
+ * System OFF y el siguiente botn arranca desde main() con ARRANQUE_DESPERTAR.
+ * LPC: solo distingue el watchdog (WDMOD.WDTOF); no tiene apagado.
  */
-void hal_consumo_dormir(void);
+uint32_t hal_consumo_causa_arranque(void);
 
 #endif /* HAL_CONSUMO_H */
@@ -9,6 +9,7 @@
 #define HAL_EXT_INT_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /**
  * @brief Tipo de dato para la función de callback.
@@ -73,4 +74,30 @@ void hal_ext_int_habilitar_despertar(uint32_t id_linea);
  */
 void hal_ext_int_deshabilitar_despertar(uint32_t id_linea);
 
+/**
+ * @brief Devuelve el instante hardware del primer flanco de una línea.
+ *
+ * Donde la placa lo permite (nRF: GPIOTE IN -> PPI -> captura de timer), el primer
+ * flanco activo tras hal_ext_int_habilitar se fecha por hardware, sin la latencia
+ * de entrada a la ISR ni las esperas por otras IRQ. Los rebotes posteriores no lo
+ * sobrescriben hasta la siguiente habilitación.
+ *
+ * @param id_linea El canal lógico (0..N).
+ * @param tick     Instante en la base de hal_tiempo_actual_tick64.
+ * @return false si no hay marca hardware (placa sin captura, o timer de captura parado):
+ *         el llamante debe usar su propia lectura del tiempo.
+ */
+bool hal_ext_int_marca_flanco(uint32_t id_linea, uint64_t *tick);
+
+/**
+ * @brief Devuelve (y olvida) las líneas que quedaron marcadas antes de arrancar.
+ *
+ * Tras un arranque en frío desde apagado (nRF: System OFF despertado por SENSE) el
+ * pin que despertó sigue apuntado en el LATCH del puerto. Se llama una vez, antes de
+ * hal_ext_int_iniciar, para que la ISR no lo confunda con una pulsación nueva.
+ *
+ * @return Máscara de líneas lógicas (bit i = línea i). 0 en placas sin apagado.
+ */
+uint32_t hal_ext_int_despertar(void);
+
 #endif // HAL_EXT_INT_H
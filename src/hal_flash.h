@@ -0,0 +1,40 @@
+/* *****************************************************************************
+ * P.H.2025: HAL de la flash interna (borrado y programación en tiempo de ejecución)
+ *
+ * nRF52840: NVMC, páginas de 4 KB, programación por palabras.
+ * LPC2105:  IAP de la ROM de arranque, sectores de 8 KB, programación por bloques de 256 B.
+ * La lectura no pasa por aquí: la flash está mapeada en memoria.
+ */
+#ifndef HAL_FLASH_H
+#define HAL_FLASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Tamaño en bytes de la unidad mínima de borrado (página/sector).
+ */
+uint32_t hal_flash_tam_pagina(void);
+
+/**
+ * @brief Borra (a 0xFF) la página que empieza en dir.
+ *
+ * Bloquea la CPU lo que dure el borrado (~85 ms en nRF, hasta ~400 ms en LPC):
+ * solo debe llamarse cuando no haya plazos que cumplir.
+ *
+ * @return false si dir no está alineada a página o el hardware informa de error.
+ */
+bool hal_flash_borrar_pagina(uint32_t dir);
+
+/**
+ * @brief Programa num palabras a partir de dir (alineada a 4).
+ *
+ * La flash solo pasa bits de 1 a 0: las palabras de destino deben estar borradas
+ * (una palabra 0xFFFFFFFF en datos deja la de destino como estaba).
+ *
+ * @return false si dir no está alineada o el hardware informa de error.
+ */
+bool hal_flash_escribir(uint32_t dir, const uint32_t *datos, uint32_t num);
+
+#endif /* HAL_FLASH_H */
@@ -14,6 +14,7 @@
 #define HAL_GPIO_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /* Direccin de los GPIOs (E/S) */
 typedef enum {
@@ -48,6 +49,31 @@ void hal_gpio_sentido(HAL_GPIO_PIN_T gpio, hal_gpio_pin_dir_t direccion);
  */
 uint32_t hal_gpio_leer(HAL_GPIO_PIN_T gpio);
 
+/**
+ * @brief Configura un GPIO como entrada legible, con pull-up si se pide.
+ *
+ * Para entradas que se muestrean sin pasar por hal_ext_int (que ya las configura).
+ *
+ * @param gpio   Pin a configurar.
+ * @param pullup Distinto de 0 para activar la resistencia de pull-up (si la placa la tiene).
+ */
+void hal_gpio_entrada(HAL_GPIO_PIN_T gpio, uint32_t pullup);
+
+/* Puerto de un pin y su bit dentro del puerto (32 pines por puerto) */
+#define HAL_GPIO_PUERTO(gpio)   ((uint8_t)((gpio) >> 5))
+#define HAL_GPIO_BIT(gpio)      ((uint32_t)(gpio) & 0x1Fu)
+#define HAL_GPIO_PUERTOS_MAX    2
+
+/**
+ * @brief Lee de una vez el nivel de los 32 pines de un puerto.
+ *
+ * Para muestrear muchas entradas con un solo acceso al periferico.
+ *
+ * @param puerto Puerto (HAL_GPIO_PUERTO del pin); 0 si la placa solo tiene uno.
+ * @return Bit n a 1 si el pin n del puerto esta a nivel alto (0 si no existe el puerto).
+ */
+uint32_t hal_gpio_leer_puerto(uint8_t puerto);
+
 /**
  * @brief Escribe un valor lgico en un GPIO.
  *
@@ -56,4 +82,34 @@ uint32_t hal_gpio_leer(HAL_GPIO_PIN_T gpio);
  */
 void hal_gpio_escribir(HAL_GPIO_PIN_T gpio, uint32_t valor);
 
+/**
+ * @brief Escribe de una vez varios pines de salida de un puerto.
+ * Los pines de la mascara cambian en el mismo acceso (LPC: IOSET + IOCLR).
+ * @param puerto  Puerto (HAL_GPIO_PUERTO del pin).
+ * @param mascara Bit n a 1 = el pin n se escribe.
+ * @param valores Bit n = nivel del pin n (solo cuentan los de la mascara).
+ */
+void hal_gpio_escribir_puerto(uint8_t puerto, uint32_t mascara, uint32_t valores);
+
+/* --- Marco de salidas en un disparo hardware de hal_tiempo ---
+ * Un grupo de pines de salida que cambia a la vez, por hardware, en el instante de
+ * hal_tiempo_disparo_tick(disparo, ...) (nRF: GPIOTE en modo tarea + PPI). */
+#define HAL_GPIO_MARCO_MAX 4
+
+/**
+ * @brief Deja armados los niveles de un grupo de pines para el proximo disparo.
+ * Sigue armado hasta el siguiente armado o hal_gpio_marco_cancelar (el comparador
+ * vuelve a coincidir a cada vuelta del contador: cancelar si ya no se quiere).
+ * hal_gpio_escribir sobre esos pines sigue funcionando.
+ * @param disparo Disparo de hal_tiempo que lo cambia.
+ * @param pines   Pines de salida (los mismos en cada llamada).
+ * @param num     Numero de pines (<= HAL_GPIO_MARCO_MAX).
+ * @param niveles Bit i = nivel de pines[i].
+ * @return false si la placa no tiene disparo hardware de salidas.
+ */
+bool hal_gpio_marco_armar(uint8_t disparo, const HAL_GPIO_PIN_T *pines, uint8_t num, uint32_t niveles);
+
+/* Anula el marco armado (si no ha saltado todavia) */
+void hal_gpio_marco_cancelar(void);
+
 #endif /* HAL_GPIO_H */
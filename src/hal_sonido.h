@@ -9,6 +9,7 @@
 #define HAL_SONIDO_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /**
  * @brief Inicializa el subsistema de sonido (HAL).
@@ -19,13 +20,83 @@
 void hal_sonido_iniciar(void);
 
 /**
- * @brief Genera un tono con la frecuencia y duración especificadas.
+ * @brief Arranca un tono de la frecuencia indicada y vuelve enseguida.
  * 
- * NOTA: Esta implementación es BLOQUEANTE (detiene la ejecución durante 'ms').
+ * El tono sigue sonando hasta hal_sonido_parar (la duración la lleva el driver).
  * 
- * @param frecuencia_hz Frecuencia del tono en Hz (ej. 1000 para 1kHz).
- * @param duracion_ms Duración del tono en milisegundos.
+ * @param frecuencia_hz Frecuencia del tono en Hz (ej. 1000 para 1kHz). 0 = parar.
  */
-void hal_sonido_tocar(uint32_t frecuencia_hz, uint32_t duracion_ms);
+void hal_sonido_iniciar_tono(uint32_t frecuencia_hz);
+
+/**
+ * @brief Detiene el tono o la secuencia en curso (si lo hay).
+ *
+ * Una secuencia parada así no llama a su callback de fin.
+ */
+void hal_sonido_parar(void);
+
+/* Nota de una secuencia. frecuencia_hz 0 = silencio de esa duración */
+typedef struct {
+    uint16_t frecuencia_hz;
+    uint16_t duracion_ms;
+    uint8_t  ciclo_pct;     // ciclo de trabajo (volumen/timbre), 1..99; 0 = 50%
+} hal_sonido_nota_t;
+
+/**
+ * @brief Toca una lista de notas con la temporización en hardware.
+ *
+ * Vuelve enseguida. Las notas se leen del array del llamante, que debe seguir
+ * existiendo hasta el final (p.ej. const en flash). Al acabar la última nota
+ * se llama a fin_cb desde la IRQ. Sustituye a cualquier tono o secuencia en curso,
+ * que desde aquí ya no avisa (nRF: arranca cuando el PWM acaba su periodo, sin
+ * esperarlo en el llamante).
+ *
+ * @return false si la placa no puede secuenciar por hardware (el driver lo hace
+ *         entonces nota a nota con drv_tiempo).
+ */
+bool hal_sonido_secuencia(const hal_sonido_nota_t *notas, uint8_t num_notas, void (*fin_cb)(void));
+
+/* --- Reproducción PCM ---
+ * Muestras de salida sin signo de 8 bits (0..HAL_SONIDO_PCM_MAX, reposo en el medio),
+ * en bloques de HAL_SONIDO_PCM_BLOQUE que el HAL pide mientras suena el anterior. */
+#define HAL_SONIDO_PCM_MAX      255u
+#define HAL_SONIDO_PCM_BLOQUE   128u
+
+/**
+ * @brief Arranca la salida PCM continua.
+ *
+ * rellenar(bloque, n) se llama desde la IRQ cada vez que un bloque ha terminado de
+ * leerse (y dos veces al arrancar: aquí, o en la IRQ que para lo que sonaba) y debe
+ * escribir n muestras. Si devuelve false, ese
+ * bloque es el último: suena y el PWM se para. Sustituye a cualquier tono o secuencia.
+ * Con rellenar = NULL solo devuelve la frecuencia, sin tocar lo que esté sonando.
+ *
+ * @return Frecuencia de muestreo de salida en Hz, o 0 si la placa no tiene salida PCM.
+ */
+uint32_t hal_sonido_pcm(bool (*rellenar)(uint16_t *bloque, uint32_t n));
+
+/**
+ * @brief Deja preparado un click que arranca por hardware con el disparo 'disparo'
+ * de hal_tiempo.
+ *
+ * Cuando salta hal_tiempo_disparo_tick el PWM empieza a sonar sin pasar por la CPU
+ * (nRF: PPI del evento de TIMER4 a TASKS_SEQSTART[0]). Un armado da un solo click.
+ * Si suena otra cosa (o empieza a sonar antes del disparo) el click queda pendiente y
+ * se vuelve a enlazar cuando el PWM se para, si el disparo aún no ha saltado.
+ *
+ * @return false si la placa no puede enlazar el disparo con el sonido.
+ */
+bool hal_sonido_click_armar(uint8_t disparo, uint32_t frecuencia_hz, uint32_t duracion_ms);
+
+/**
+ * @brief Quita el click armado o pendiente. Llamar antes de reprogramar el disparo:
+ * con el enlace puesto, el comparador a medio cambiar podría arrancarlo.
+ */
+void hal_sonido_click_cancelar(void);
+
+/**
+ * @brief true mientras suena algo (tono, secuencia o PCM).
+ */
+bool hal_sonido_activo(void);
 
 #endif // HAL_SONIDO_H
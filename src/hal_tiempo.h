@@ -29,17 +29,117 @@ void hal_tiempo_iniciar_tick(hal_tiempo_info_t *out_info);
 uint64_t hal_tiempo_actual_tick64(void);
 
 
-/* --- Reloj peridico por IRQ --- */
+/* --- Canales de temporizacion por IRQ --- */
+/* Comparadores independientes sobre un contador libre (LPC: T0 MR0..MR3,
+ * nRF: TIMER3 CC[0..3] o RTC2 CC[0..3] con HAL_TIEMPO_RTC). Cada canal es
+ * periodico o de un solo disparo y tiene su propio callback. */
+#define HAL_TIEMPO_CANALES 4
 
-/* Configura el periodo en ticks (no arranca) */
-void hal_tiempo_periodico_config_tick(uint32_t periodo_en_tick);
+/* Configura periodo en ticks y si se repite (no arranca) */
+void hal_tiempo_canal_config_tick(uint8_t canal, uint32_t periodo_en_tick, bool periodico);
 
-/* Registra el callback llamado desde la IRQ */
-void hal_tiempo_periodico_set_callback(void (*cb)());
+/* Registra el callback llamado desde la IRQ con el numero de canal */
+void hal_tiempo_canal_set_callback(uint8_t canal, void (*cb)(uint8_t canal));
 
-/* Habilita/Deshabilita el reloj peridico */
-void hal_tiempo_periodico_enable(bool enable);
+/* Habilita (el periodo cuenta desde ahora) / Deshabilita el canal */
+void hal_tiempo_canal_enable(uint8_t canal, bool enable);
 
-void hal_tiempo_reloj_periodico_tick(uint32_t periodo_en_tick,void (*funcion_callback_drv)());
+/* Todo a la vez; periodo 0 o callback NULL dejan el canal parado */
+void hal_tiempo_canal_tick(uint8_t canal, uint32_t periodo_en_tick, bool periodico, void (*funcion_callback_drv)(uint8_t canal));
+
+
+/* --- Alarma one-shot sobre el contador libre --- */
+
+/**
+ * Programa una unica IRQ cuando el contador libre alcance deadline_tick
+ * (valor absoluto, misma base que hal_tiempo_actual_tick64).
+ * Si el instante ya ha pasado la IRQ salta inmediatamente.
+ * Solo hay una alarma: programar otra sustituye a la anterior.
+ */
+void hal_tiempo_alarma_tick(uint64_t deadline_tick, void (*funcion_callback_drv)());
+
+/* Anula la alarma one-shot pendiente (si la hay) */
+void hal_tiempo_alarma_cancelar(void);
+
+/* Sin vencimiento programado */
+#define HAL_TIEMPO_NUNCA  UINT64_MAX
+
+/**
+ * Instante (misma base que hal_tiempo_actual_tick64) del proximo vencimiento
+ * programado: la alarma o el canal activo mas cercano. HAL_TIEMPO_NUNCA si no
+ * hay ninguno. Sirve para saber cuanto puede dormir la CPU sin llegar tarde.
+ */
+uint64_t hal_tiempo_proximo_tick(void);
+
+
+/* --- Captura hardware de instantes --- */
+/* Ranuras que otro periferico dispara por hardware para fechar un flanco sin
+ * pasar por una ISR (nRF: PPI -> TASKS_CAPTURE de TIMER4, en la base de TIMER1).
+ * En el LPC no hay: los EINT no pueden disparar las capturas de los timers. */
+#define HAL_TIEMPO_CAPTURAS 4
+
+/* Direccion de la tarea que captura en la ranura n (para el TEP de un canal
+ * PPI), o 0 si la placa no tiene captura hardware */
+uint32_t hal_tiempo_captura_tarea(uint8_t n);
+
+/**
+ * Instante de la ultima captura de la ranura n, en la base de
+ * hal_tiempo_actual_tick64. Debe leerse antes de una vuelta de 32 bits
+ * (~268 s). Devuelve false si ahora no hay captura valida (LPC, o nRF con
+ * HAL_TIEMPO_RTC fuera de alta resolucion: el timer de captura esta parado).
+ */
+bool hal_tiempo_captura_tick64(uint8_t n, uint64_t *tick);
+
+
+/* --- Disparo hardware en un instante ---
+ * Comparadores en la base del contador libre sin IRQ: su evento lo lleva otro
+ * periferico por PPI a una tarea (nRF: TIMER4 CC[5] y CC[4], en la misma base que
+ * las capturas). Sirve para que algo ocurra en el instante exacto sin la CPU.
+ * Cada disparo n (0..HAL_TIEMPO_DISPAROS-1) es de un solo usuario. */
+#define HAL_TIEMPO_DISPAROS 2
+
+/* Direccion del evento del disparo n (para el EEP de un canal PPI), o 0 si no hay */
+uint32_t hal_tiempo_disparo_evento(uint8_t n);
+
+/**
+ * Programa el disparo n en deadline_tick (base de hal_tiempo_actual_tick64).
+ * Programarlo otra vez sustituye al anterior. Devuelve false si ya ha pasado, si
+ * esta a mas de una vuelta de 32 bits o si el timer de captura esta parado
+ * (mismas condiciones que hal_tiempo_captura_tick64).
+ */
+bool hal_tiempo_disparo_tick(uint8_t n, uint64_t deadline_tick);
+
+/* true si el disparo n ya ha saltado desde que se programo */
+bool hal_tiempo_disparo_saltado(uint8_t n);
+
+
+/* --- Resolucion del contador libre --- */
+
+/**
+ * Enciende (esperando a que arranque: ~360 us en nRF) o apaga el oscilador del
+ * reloj rapido. Solo el oscilador: no cambia la base de tiempo, asi que no hace
+ * falta seccion critica. En placas sin base de baja frecuencia no hace nada.
+ */
+void hal_tiempo_reloj_rapido(bool encender);
+
+/**
+ * En placas cuya base de tiempo en reposo es de baja frecuencia (nRF con
+ * HAL_TIEMPO_RTC: 30.5 us) pasa la base al reloj rapido (o la devuelve) para
+ * medir en fraccion de us. La cuenta sigue siendo continua y monotona al cambiar.
+ * Activar con hal_tiempo_reloj_rapido(true) ya hecho; desactivar antes de apagarlo.
+ * Llamar sin que la IRQ de la alarma pueda entrar (re-arma la alarma).
+ * En el resto no hace nada (la base ya es de alta resolucion).
+ */
+void hal_tiempo_alta_resolucion(bool activar);
+
+/* --- Contador de ciclos --- */
+
+/**
+ * Ciclos de CPU (CPU_CLOCK_MHZ por us), 32 bits que dan la vuelta: para medir
+ * intervalos cortos sin depender de la resolucion de la base de tiempo.
+ * nRF: DWT->CYCCNT (no cuenta con la CPU dormida). LPC: el ARM7 no tiene contador
+ * de ciclos; se escala el tick de T1 (resolucion de 4 ciclos).
+ */
+uint32_t hal_tiempo_ciclos(void);
 
 #endif // HAL_TIEMPO
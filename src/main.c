@@ -4,16 +4,19 @@
 #include "drv_leds.h"
 #include "drv_tiempo.h"
 #include "drv_consumo.h"
+#include "drv_SC.h"
 #include "drv_monitor.h"
 #include "rt_fifo.h"
 #include "drv_botones.h"
 #include "rt_ge.h"
 #include "svc_alarmas.h"
+#include "svc_gestos.h"
 #include "rt_evento_t.h"
 #include "board.h"
 #include "drv_aleatorios.h" 
 #include "beat_hero.h"
 #include "drv_sonido.h"
+#include "svc_almacen.h"
 #include "test.h"
 #include "board.h" // Aquí sí incluimos board.h para saber los pines reales
 
@@ -25,11 +28,12 @@ volatile uint32_t testsPasados = 0;
 
 int main(void){
     //Inicializaciones de Hardware básico
+    drv_SC_iniciar();       // prioridades de IRQ antes que ningún periférico
     drv_tiempo_iniciar(); 
     hal_gpio_iniciar(); 
     drv_consumo_iniciar(4); 
     drv_monitor_iniciar();
-    drv_sonido_iniciar();
+    drv_sonido_iniciar(rt_FIFO_encolar, ev_SONIDO_FIN);
     drv_leds_iniciar();
   
     //Iniciamos los runtimes
@@ -42,10 +46,18 @@ int main(void){
     
     svc_alarma_iniciar(4, rt_FIFO_encolar, ev_T_PERIODICO); 
     drv_botones_iniciar(rt_FIFO_encolar, ev_PULSAR_BOTON, ev_SOLTAR_BOTON, ev_BOTON_TIMER);
+    drv_botones_encolar_con_marca(rt_FIFO_encolar_ts);
+    svc_gestos_iniciar(rt_FIFO_encolar, ev_PULSAR_BOTON, ev_SOLTAR_BOTON, ev_GESTO, ev_GESTO_TIMER);
     drv_aleatorios_iniciar(0);
+    svc_almacen_iniciar();
 
     //iniciamos el juego
     beat_hero_iniciar();
+
+    // Arranque en frío por un botón (System OFF): su pulsación es el primer evento
+    if (drv_consumo_causa_arranque() & HAL_CONSUMO_ARRANQUE_DESPERTAR) {
+        drv_botones_despertar();
+    }
     
     // Lanzar el despachador de eventos (Bucle infinito)
     rt_GE_lanzador();
@@ -0,0 +1,25 @@
+/* *****************************************************************************
+ * P.H.2025: Partituras de Beat Hero
+ * GENERADO por tools/partitura.py: no editar, cambiar los .txt de tools/partituras
+ */
+#include "svc_partitura.h"
+
+/* 0_clasica.txt (23 bytes) */
+static const uint8_t s_partitura_0_clasica[] = {
+    0x90, 0xE8, 0x03, 0xA1, 0xB4, 0xA2, 0xB4, 0xA3, 0xB4, 0xA4, 0x90, 0x84,
+    0x03, 0xB4, 0x90, 0x2A, 0x03, 0xB4, 0x90, 0xD9, 0x02, 0xB4, 0x80,
+};
+
+/* 1_tutorial.txt (36 bytes) */
+static const uint8_t s_partitura_1_tutorial[] = {
+    0x90, 0xE8, 0x03, 0xA1, 0x01, 0x02, 0x01, 0x02, 0x00, 0xA2, 0x11, 0x12,
+    0x03, 0x00, 0xA3, 0x90, 0x52, 0x03, 0x01, 0x03, 0x02, 0x03, 0x01, 0x02,
+    0xA4, 0x90, 0xBC, 0x02, 0x23, 0x01, 0x02, 0x01, 0x02, 0x13, 0x00, 0x80,
+};
+
+const svc_partitura_t g_partituras[] = {
+    { "Clasica", s_partitura_0_clasica, sizeof(s_partitura_0_clasica) },
+    { "Tutorial", s_partitura_1_tutorial, sizeof(s_partitura_1_tutorial) },
+};
+
+const uint8_t g_num_partituras = sizeof(g_partituras) / sizeof(g_partituras[0]);
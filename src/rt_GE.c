@@ -11,13 +11,13 @@
 #include "drv_WDT.h"
 #include "rt_GE.h"
 #include "drv_tiempo.h" 
+#include "svc_almacen.h"
 
 
 #define sec 1
 #define prioridad_alta 0
 #define prioridad_baja 1
 
-#define INACTIVITY_TIME_MS 10000 
 static uint32_t g_M_overflow_monitor_id;
 #define rt_GE_MAX_SUSCRITOS 4 
 
@@ -35,6 +35,9 @@ volatile uint32_t dbg_ge_latencia_min = 0xFFFFFFFF;
 volatile uint32_t dbg_ge_latencia_max = 0;
 // [0]:<1ms, [1]:<10ms, [2]:<50ms, [3]:<100ms, [4]:>100ms
 volatile uint32_t dbg_ge_hist[5] = {0,0,0,0,0};
+// Arranque: desde que corre la base de tiempo (inicio de main) al primer evento despachado
+volatile uint32_t dbg_ge_arranque_us = 0;
+volatile uint32_t dbg_ge_arranque_evento = 0xFFFFFFFF;
 
 static void registrar_latencia(Tiempo_us_t ts_evento) {
     Tiempo_us_t ahora = drv_tiempo_actual_us();
@@ -76,22 +79,26 @@ void rt_GE_lanzador(void) {
     uint32_t auxData;
     Tiempo_us_t timestamp; 
     
-    uint32_t alarma_inactividad_flags = svc_alarma_codificar(false, INACTIVITY_TIME_MS, 0);
-    svc_alarma_activar(alarma_inactividad_flags, ev_INACTIVIDAD, 0);
+    uint32_t alarma_inactividad_flags = svc_alarma_codificar(false, RT_GE_INACTIVIDAD_MS, 0);
+    svc_alarma_activar_holgura(alarma_inactividad_flags, ev_INACTIVIDAD, 0, RT_GE_HOLGURA_INACTIVIDAD_MS);
 
     while(1) {
         
         uint32_t sc = drv_SC_entrar_disable_irq();
 				drv_WDT_alimentar();
-			  drv_SC_salir_enable_irq();
+			  drv_SC_salir_enable_irq(sc);
         
 			  sc = drv_SC_entrar_disable_irq();
         if (rt_FIFO_extraer(&evento, &auxData, &timestamp)) {
 						
-            drv_SC_salir_enable_irq();
+            drv_SC_salir_enable_irq(sc);
             
             #ifdef DEBUG
             registrar_latencia(timestamp);
+            if (dbg_ge_arranque_evento == 0xFFFFFFFF) {
+                dbg_ge_arranque_us = (uint32_t)drv_tiempo_actual_us();
+                dbg_ge_arranque_evento = evento;
+            }
             #endif
 
             if (evento < EVENT_TYPES) { 
@@ -103,8 +110,11 @@ void rt_GE_lanzador(void) {
             }
             
         } else {
-            drv_SC_salir_enable_irq();
-            drv_consumo_esperar();
+            drv_SC_salir_enable_irq(sc);
+            // Hueco ocioso: primero las escrituras diferidas a flash, luego a dormir
+            if (!svc_almacen_volcar()) {
+                drv_consumo_reposar();
+            }
         }
     }
 }
@@ -112,12 +122,21 @@ void rt_GE_lanzador(void) {
 void rt_GE_actualizar(EVENTO_T ID_evento, uint32_t auxiliar){
     switch (ID_evento) {
         case ev_INACTIVIDAD:
-            drv_consumo_dormir();
+        {
+            // La RAM se conserva al dormir, pero no si se agota la pila: se guarda antes
+            svc_almacen_volcar_todo();
+            // Botones por sondeo: nada despertaría; se queda en el reposo del bucle ocioso
+            if (drv_botones_despiertan()) drv_consumo_dormir();
+            // De vuelta con el estado intacto; se rearma la inactividad por si la
+            // pulsación que despertó no llega a confirmarse
+            uint32_t alarma_flags = svc_alarma_codificar(false, RT_GE_INACTIVIDAD_MS, 0);
+            svc_alarma_activar_holgura(alarma_flags, ev_INACTIVIDAD, 0, RT_GE_HOLGURA_INACTIVIDAD_MS);
             break;
+        }
         case ev_PULSAR_BOTON: 
         {
-            uint32_t alarma_flags = svc_alarma_codificar(false, INACTIVITY_TIME_MS, 0);
-            svc_alarma_activar(alarma_flags, ev_INACTIVIDAD, 0);
+            uint32_t alarma_flags = svc_alarma_codificar(false, RT_GE_INACTIVIDAD_MS, 0);
+            svc_alarma_activar_holgura(alarma_flags, ev_INACTIVIDAD, 0, RT_GE_HOLGURA_INACTIVIDAD_MS);
             break;
         }
         default:
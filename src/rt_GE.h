@@ -6,6 +6,13 @@
 #include <stddef.h>
 #include "rt_evento_t.h"
 typedef void (*f_callback_GE)(EVENTO_T evento, uint32_t aux);
+
+/* Alarma de inactividad (ev_INACTIVIDAD): la rearman el runtime y el juego con
+ * estos mismos valores. Dormir un poco más tarde no importa: la holgura deja que
+ * se agrupe con otras alarmas. */
+#define RT_GE_INACTIVIDAD_MS          10000
+#define RT_GE_HOLGURA_INACTIVIDAD_MS  1000
+
 /**
  * @brief Inicializa el Gestor de Eventos (capa Run-Time).
  *
@@ -19,9 +19,12 @@ typedef enum {
     ev_USUARIO_1 = 5,
     ev_JUEGO_NUEVO_LED = 6,
     ev_JUEGO_TIMEOUT = 7,
-    ev_SOLTAR_BOTON = 8  
+    ev_SOLTAR_BOTON = 8,
+    ev_GESTO = 9,
+    ev_GESTO_TIMER = 10,
+    ev_SONIDO_FIN = 11
 } EVENTO_T;
-#define EVENT_TYPES 9
+#define EVENT_TYPES 12
 
 
 typedef struct {
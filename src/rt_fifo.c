@@ -45,12 +45,16 @@ void rt_FIFO_inicializar(uint32_t monitor_overflow){
 }
 
 void rt_FIFO_encolar(uint32_t ID_evento, uint32_t auxData){
+  rt_FIFO_encolar_ts(ID_evento, auxData, drv_tiempo_actual_us());
+}
+
+void rt_FIFO_encolar_ts(uint32_t ID_evento, uint32_t auxData, Tiempo_us_t TS){
   if (!s_iniciado) return;
   
   EVENTO ev;
   ev.ID_EVENTO = (EVENTO_T)ID_evento;
   ev.auxData = auxData;
-  ev.TS = drv_tiempo_actual_us();
+  ev.TS = TS;
 
   // --- SECCIÓN CRÍTICA: INICIO ---
   uint32_t estado_anterior = drv_SC_entrar_disable_irq();
@@ -75,7 +79,7 @@ void rt_FIFO_encolar(uint32_t ID_evento, uint32_t auxData){
   if (s_rt_fifo.eventos_a_tratar > TAMCOLA) 
   {
     drv_monitor_marcar(s_rt_fifo.monitor);
-    drv_SC_salir_enable_irq();
+    drv_SC_salir_enable_irq(estado_anterior);
     while (1);
   }
   
@@ -83,7 +87,7 @@ void rt_FIFO_encolar(uint32_t ID_evento, uint32_t auxData){
   s_rt_fifo.cola[indice] = ev;
 
   // --- SECCIÓN CRÍTICA: FIN ---
-  drv_SC_salir_enable_irq(); 
+  drv_SC_salir_enable_irq(estado_anterior); 
 }
 
 uint8_t rt_FIFO_extraer(EVENTO_T *ID_evento, uint32_t *auxData, Tiempo_us_t *TS){
@@ -91,7 +95,7 @@ uint8_t rt_FIFO_extraer(EVENTO_T *ID_evento, uint32_t *auxData, Tiempo_us_t *TS)
   uint32_t estado_anterior = drv_SC_entrar_disable_irq();
 
   if(s_rt_fifo.eventos_a_tratar==0) {
-      drv_SC_salir_enable_irq();
+      drv_SC_salir_enable_irq(estado_anterior);
       return 0;
   }
   
@@ -109,7 +113,7 @@ uint8_t rt_FIFO_extraer(EVENTO_T *ID_evento, uint32_t *auxData, Tiempo_us_t *TS)
   uint8_t ret = s_rt_fifo.eventos_a_tratar == 0 ? 1 : s_rt_fifo.eventos_a_tratar;
 
   // --- SECCIÓN CRÍTICA: FIN ---
-  drv_SC_salir_enable_irq();
+  drv_SC_salir_enable_irq(estado_anterior);
 
   if (ID_evento) *ID_evento = ev.ID_EVENTO;
   if (auxData)   *auxData = ev.auxData;
@@ -23,6 +23,12 @@ void rt_FIFO_inicializar(uint32_t monitor_overflow);
  */
 void rt_FIFO_encolar(uint32_t ID_evento, uint32_t auxData);
 
+/**
+ * igual que rt_FIFO_encolar, pero con la marca de tiempo ya tomada
+ * (p.ej. el instante hardware de un flanco, anterior a la ISR)
+ */
+void rt_FIFO_encolar_ts(uint32_t ID_evento, uint32_t auxData, Tiempo_us_t TS);
+
 /**
  * 
  */
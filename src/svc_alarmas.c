@@ -7,10 +7,13 @@
 #include "svc_alarmas.h"
 #include "rt_fifo.h"
 #include "rt_GE.h" 
+#include "drv_SC.h"
 
 
 #define svc_ALARMAS_MAX 8 
-#define tiempo_periodico 1
+#define svc_ALARMAS_US_MAX 4
+// Máximo entre despertares aunque no haya alarmas: el bucle del GE alimenta el WDT (1 s)
+#define svc_ALARMA_ESPERA_MAX_MS 500
 
 #define MASK_RETARDO    0x00FFFFFF
 #define MASK_FLAGS      0x7F000000
@@ -20,22 +23,49 @@ typedef struct {
     bool activa;
     bool periodica;
     uint32_t retardo_ms;
-    uint32_t contador;
+    uint32_t holgura_ms;        // Puede retrasarse hasta este margen para compartir despertar
+    Tiempo_us_t vencimiento_us; // Plazo absoluto sobre drv_tiempo_actual_us
     EVENTO_T ID_evento;
     uint32_t auxData;
+    bool agrupada;          // Se entrega dentro del evento de grupo de ID_evento
 } Alarma_t;
 
+// Acumulador de un grupo durante una pasada de svc_alarma_actualizar
+typedef struct {
+    EVENTO_T ID_evento;
+    uint32_t mascara;
+} GrupoVencido_t;
+
+// Alarmas en microsegundos: plazo absoluto, las dispara el comparador hardware
+typedef struct {
+    bool activa;
+    Tiempo_us_t vencimiento_us;
+    Tiempo_us_t periodo_us;
+    EVENTO_T ID_evento;
+    uint32_t auxData;
+} AlarmaUs_t;
+
 static Alarma_t m_alarmas[svc_ALARMAS_MAX];
+static AlarmaUs_t m_alarmas_us[svc_ALARMAS_US_MAX];
 static void (*m_cb_a_llamar)(uint32_t, uint32_t); 
 static EVENTO_T m_ev_a_notificar;
 static uint32_t g_M_overflow_monitor_id;
 
+// Despertar interno del servicio: comparte el comparador con las alarmas en us
+static bool m_despertar_activo;
+static Tiempo_us_t m_despertar_us;
+
 #ifdef DEBUG
 // --- VARIABLES GLOBALES DE DEPURACIÓN (Sin static, con volatile) ---
 volatile uint32_t dbg_alarmas_activas = 0;
 volatile uint32_t dbg_alarmas_max_uso = 0;
+volatile uint32_t dbg_alarmas_despertares = 0; // Pasadas de svc_alarma_actualizar
+volatile uint32_t dbg_alarmas_vencidas = 0;    // Alarmas en ms vencidas (vencidas/despertares = agrupamiento)
 #endif
 
+static void planificar_despertar(void);
+static void alarmas_us_reprogramar(void);
+
 static inline uint32_t decodificar_retardo(uint32_t flags) {
     return flags & MASK_RETARDO;
 }
@@ -72,14 +102,22 @@ void svc_alarma_iniciar(uint32_t monitor_overflow, void(*funcion_callback_app)(u
     for (int i = 0; i < svc_ALARMAS_MAX; i++) {
         m_alarmas[i].activa = false;
     }
+    for (int i = 0; i < svc_ALARMAS_US_MAX; i++) {
+        m_alarmas_us[i].activa = false;
+    }
+    
+    m_despertar_activo = false;
     
     #ifdef DEBUG
     dbg_alarmas_activas = 0;
     dbg_alarmas_max_uso = 0;
+    dbg_alarmas_despertares = 0;
+    dbg_alarmas_vencidas = 0;
     #endif
 
+    // Sin tick periódico: el comparador despierta solo cuando hay algo que vencer
     rt_GE_suscribir(m_ev_a_notificar, 0, svc_alarma_actualizar);
-    drv_tiempo_periodico_ms(tiempo_periodico, m_cb_a_llamar, m_ev_a_notificar);
+    planificar_despertar();
 }
 
 uint32_t svc_alarma_codificar(bool periodico, uint32_t retardo_ms, uint8_t flags) {
@@ -92,7 +130,7 @@ uint32_t svc_alarma_codificar(bool periodico, uint32_t retardo_ms, uint8_t flags
     return alarma_flags;
 }
 
-void svc_alarma_activar(uint32_t alarma_flags, EVENTO_T ID_evento, uint32_t auxData) {
+static Alarma_t* programar_alarma(uint32_t alarma_flags, EVENTO_T ID_evento, uint32_t auxData, bool agrupada, uint32_t holgura_ms) {
     
     Alarma_t* alarma = buscar_alarma(ID_evento, auxData);
     
@@ -103,8 +141,9 @@ void svc_alarma_activar(uint32_t alarma_flags, EVENTO_T ID_evento, uint32_t auxD
             #ifdef DEBUG
             if (dbg_alarmas_activas > 0) dbg_alarmas_activas--;
             #endif
+            planificar_despertar();
         }
-        return;
+        return NULL;
     }
     
     // Caso 2: Programar o Reprogramar
@@ -128,29 +167,111 @@ void svc_alarma_activar(uint32_t alarma_flags, EVENTO_T ID_evento, uint32_t auxD
     alarma->activa = true;
     alarma->periodica = decodificar_periodica(alarma_flags);
     alarma->retardo_ms = decodificar_retardo(alarma_flags);
-    alarma->contador = alarma->retardo_ms; 
+    alarma->holgura_ms = holgura_ms;
+    alarma->vencimiento_us = drv_tiempo_actual_us() + (Tiempo_us_t)alarma->retardo_ms * 1000;
     alarma->ID_evento = ID_evento;
     alarma->auxData = auxData; 
+    alarma->agrupada = agrupada;
+    return alarma;
+}
+
+void svc_alarma_activar(uint32_t alarma_flags, EVENTO_T ID_evento, uint32_t auxData) {
+    svc_alarma_activar_holgura(alarma_flags, ID_evento, auxData, 0);
+}
+
+void svc_alarma_activar_holgura(uint32_t alarma_flags, EVENTO_T ID_evento, uint32_t auxData, uint32_t holgura_ms) {
+    if (programar_alarma(alarma_flags, ID_evento, auxData, false, holgura_ms) != NULL) {
+        planificar_despertar();
+    }
+}
+
+void svc_alarma_activar_grupo(uint32_t alarma_flags, EVENTO_T ID_evento, uint8_t miembro, uint32_t holgura_ms) {
+    if (miembro >= SVC_ALARMA_GRUPO_MAX) return;
+
+    Alarma_t* alarma = programar_alarma(alarma_flags, ID_evento, miembro, true, holgura_ms);
+    if (alarma == NULL) return;
+
+    if (alarma->periodica) {
+        // Alinear la fase con otra periódica del grupo con el mismo periodo
+        for (int i = 0; i < svc_ALARMAS_MAX; i++) {
+            Alarma_t* otra = &m_alarmas[i];
+            if (otra != alarma && otra->activa && otra->agrupada && otra->periodica &&
+                otra->ID_evento == ID_evento && otra->retardo_ms == alarma->retardo_ms) {
+                alarma->vencimiento_us = otra->vencimiento_us;
+                break;
+            }
+        }
+    }
+    planificar_despertar();
+}
+
+// Recalcula el próximo despertar: el límite (plazo + holgura) más cercano.
+// Así varias alarmas con margen caen en la misma pasada y se despierta una sola vez.
+static void planificar_despertar(void) {
+    Tiempo_us_t limite = drv_tiempo_actual_us() + (Tiempo_us_t)svc_ALARMA_ESPERA_MAX_MS * 1000;
+
+    for (int i = 0; i < svc_ALARMAS_MAX; i++) {
+        if (m_alarmas[i].activa) {
+            Tiempo_us_t l = m_alarmas[i].vencimiento_us + (Tiempo_us_t)m_alarmas[i].holgura_ms * 1000;
+            if (l < limite) {
+                limite = l;
+            }
+        }
+    }
+
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    m_despertar_us = limite;
+    m_despertar_activo = true;
+    alarmas_us_reprogramar();
+    drv_SC_salir_enable_irq(sc);
+}
+
+// Acumula el vencimiento de un miembro en su grupo (crea la entrada si no existe)
+static void acumular_en_grupo(GrupoVencido_t grupos[], uint32_t *num_grupos, const Alarma_t *alarma) {
+    uint32_t g = 0;
+    while (g < *num_grupos && grupos[g].ID_evento != alarma->ID_evento) {
+        g++;
+    }
+    if (g == *num_grupos) {
+        grupos[g].ID_evento = alarma->ID_evento;
+        grupos[g].mascara = 0;
+        (*num_grupos)++;
+    }
+    grupos[g].mascara |= (1u << alarma->auxData);
 }
 
 void svc_alarma_actualizar(EVENTO_T evento, uint32_t aux) { 
     if (evento != m_ev_a_notificar) { 
         return;
     }
+
+    GrupoVencido_t grupos[svc_ALARMAS_MAX];
+    uint32_t num_grupos = 0;
+    Tiempo_us_t ahora = drv_tiempo_actual_us();
+
+    #ifdef DEBUG
+    dbg_alarmas_despertares++;
+    #endif
     
+    // Vencen todas las que ya han alcanzado su plazo, no solo la que fijó el despertar
     for (int i = 0; i < svc_ALARMAS_MAX; i++) {
         if (m_alarmas[i].activa) {
-            if (m_alarmas[i].contador > 0) {
-                m_alarmas[i].contador--;
-            }
-            
-            if (m_alarmas[i].contador == 0) {
-                if (m_cb_a_llamar) { 
+            if (m_alarmas[i].vencimiento_us <= ahora) {
+                #ifdef DEBUG
+                dbg_alarmas_vencidas++;
+                #endif
+                if (m_alarmas[i].agrupada) {
+                    acumular_en_grupo(grupos, &num_grupos, &m_alarmas[i]);
+                } else if (m_cb_a_llamar) { 
                     m_cb_a_llamar(m_alarmas[i].ID_evento, m_alarmas[i].auxData);
                 }
                 
                 if (m_alarmas[i].periodica) {
-                    m_alarmas[i].contador = m_alarmas[i].retardo_ms;
+                    // Sobre el plazo anterior (la holgura no acumula deriva); si vamos muy tarde, se recoloca
+                    m_alarmas[i].vencimiento_us += (Tiempo_us_t)m_alarmas[i].retardo_ms * 1000;
+                    if (m_alarmas[i].vencimiento_us <= ahora) {
+                        m_alarmas[i].vencimiento_us = ahora + (Tiempo_us_t)m_alarmas[i].retardo_ms * 1000;
+                    }
                 } else {
                     m_alarmas[i].activa = false;
                     #ifdef DEBUG
@@ -160,4 +281,124 @@ void svc_alarma_actualizar(EVENTO_T evento, uint32_t aux) {
             }
         }
     }
+
+    // Un único evento por grupo con la máscara de miembros vencidos
+    for (uint32_t g = 0; g < num_grupos; g++) {
+        if (m_cb_a_llamar) {
+            m_cb_a_llamar(grupos[g].ID_evento, SVC_ALARMA_AUX_GRUPO | grupos[g].mascara);
+        }
+    }
+
+    planificar_despertar();
+}
+
+/* --- Alarmas en microsegundos ---------------------------------------------- */
+
+static void alarmas_us_vencidas(void);
+
+// Programa el comparador con el vencimiento más próximo (llamar con IRQs deshabilitadas)
+static void alarmas_us_reprogramar(void) {
+    bool hay_plazo = m_despertar_activo;
+    Tiempo_us_t plazo = m_despertar_us;
+
+    for (int i = 0; i < svc_ALARMAS_US_MAX; i++) {
+        if (m_alarmas_us[i].activa &&
+            (!hay_plazo || m_alarmas_us[i].vencimiento_us < plazo)) {
+            plazo = m_alarmas_us[i].vencimiento_us;
+            hay_plazo = true;
+        }
+    }
+
+    if (hay_plazo) {
+        drv_tiempo_alarma_us(plazo, alarmas_us_vencidas);
+    } else {
+        drv_tiempo_alarma_cancelar();
+    }
+}
+
+// Callback del comparador hardware (modo IRQ): encola todas las vencidas
+static void alarmas_us_vencidas(void) {
+    Tiempo_us_t ahora = drv_tiempo_actual_us();
+
+    // Despertar de las alarmas en ms: se procesan en el bucle del GE, no en la IRQ
+    if (m_despertar_activo && m_despertar_us <= ahora) {
+        m_despertar_activo = false;
+        if (m_cb_a_llamar) {
+            m_cb_a_llamar(m_ev_a_notificar, 0);
+        }
+    }
+
+    for (int i = 0; i < svc_ALARMAS_US_MAX; i++) {
+        AlarmaUs_t* alarma = &m_alarmas_us[i];
+        if (alarma->activa && alarma->vencimiento_us <= ahora) {
+            if (m_cb_a_llamar) {
+                m_cb_a_llamar(alarma->ID_evento, alarma->auxData);
+            }
+
+            if (alarma->periodo_us != 0) {
+                // Se suma al plazo anterior (sin deriva); si vamos muy tarde, se recoloca
+                alarma->vencimiento_us += alarma->periodo_us;
+                if (alarma->vencimiento_us <= ahora) {
+                    alarma->vencimiento_us = ahora + alarma->periodo_us;
+                }
+            } else {
+                alarma->activa = false;
+            }
+        }
+    }
+
+    alarmas_us_reprogramar();
+}
+
+static AlarmaUs_t* buscar_alarma_us(EVENTO_T ID_evento, uint32_t auxData) {
+    for (int i = 0; i < svc_ALARMAS_US_MAX; i++) {
+        if (m_alarmas_us[i].activa &&
+            m_alarmas_us[i].ID_evento == ID_evento &&
+            m_alarmas_us[i].auxData == auxData) {
+            return &m_alarmas_us[i];
+        }
+    }
+    return NULL;
+}
+
+void svc_alarma_activar_us(Tiempo_us_t deadline_us, Tiempo_us_t periodo_us, EVENTO_T ID_evento, uint32_t auxData) {
+    // La tabla se comparte con la ISR del comparador
+    uint32_t sc = drv_SC_entrar_disable_irq();
+
+    AlarmaUs_t* alarma = buscar_alarma_us(ID_evento, auxData);
+    if (alarma == NULL) {
+        for (int i = 0; i < svc_ALARMAS_US_MAX && alarma == NULL; i++) {
+            if (!m_alarmas_us[i].activa) {
+                alarma = &m_alarmas_us[i];
+            }
+        }
+        if (alarma == NULL) {
+            drv_SC_salir_enable_irq(sc);
+            if (g_M_overflow_monitor_id) {
+                drv_monitor_marcar(g_M_overflow_monitor_id);
+            }
+            while(1);
+        }
+    }
+
+    alarma->vencimiento_us = deadline_us;
+    alarma->periodo_us = periodo_us;
+    alarma->ID_evento = ID_evento;
+    alarma->auxData = auxData;
+    alarma->activa = true;
+
+    alarmas_us_reprogramar();
+    drv_SC_salir_enable_irq(sc);
+}
+
+void svc_alarma_cancelar_us(EVENTO_T ID_evento, uint32_t auxData) {
+    uint32_t sc = drv_SC_entrar_disable_irq();
+
+    AlarmaUs_t* alarma = buscar_alarma_us(ID_evento, auxData);
+    if (alarma != NULL) {
+        alarma->activa = false;
+        alarmas_us_reprogramar();
+    }
+
+    drv_SC_salir_enable_irq(sc);
 }
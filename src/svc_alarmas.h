@@ -12,7 +12,8 @@
  *
  * @param monitor_overflow ID del monitor a marcar en caso de desbordamiento de slots.
  * @param funcion_callback_app Puntero a la función para encolar eventos (ej. rt_FIFO_encolar).
- * @param ev_a_notificar Evento que dispara la actualización periódica (ej. ev_T_PERIODICO).
+ * @param ev_a_notificar Evento de despertar del servicio (ej. ev_T_PERIODICO). No hay tick
+ *        fijo: el servicio lo encola desde el comparador hardware cuando hay alarmas que vencer.
  */
 void svc_alarma_iniciar(uint32_t monitor_overflow, void(*funcion_callback_app)(uint32_t, uint32_t), EVENTO_T ev_a_notificar);
 
@@ -36,15 +37,73 @@ uint32_t svc_alarma_codificar(bool periodico, uint32_t retardo_ms, uint8_t flags
 void svc_alarma_activar(uint32_t alarma_flags, EVENTO_T ID_evento, uint32_t auxData);
 
 /**
- * @brief Función de actualización del servicio de alarmas (tick handler).
+ * @brief Igual que svc_alarma_activar, pero admitiendo que venza con retraso.
  *
- * Esta función es llamada periódicamente por el Gestor de Eventos para decrementar
- * los contadores de las alarmas y disparar los eventos vencidos.
+ * La alarma nunca vence antes de su plazo, pero puede hacerlo hasta holgura_ms
+ * después. El servicio despierta en el límite (plazo + holgura) más cercano y en
+ * esa pasada vence todo lo que ya ha alcanzado su plazo, de modo que alarmas
+ * tolerantes próximas comparten un único despertar.
+ * Las periódicas se reprograman sobre el plazo, no sobre el instante de disparo.
+ *
+ * @param holgura_ms Retraso máximo tolerado (0 = exacta, como svc_alarma_activar).
+ */
+void svc_alarma_activar_holgura(uint32_t alarma_flags, EVENTO_T ID_evento, uint32_t auxData, uint32_t holgura_ms);
+
+/* Marca de auxData en los eventos de grupo: bit alto + máscara de miembros vencidos */
+#define SVC_ALARMA_AUX_GRUPO   0x80000000u
+#define SVC_ALARMA_GRUPO_MAX   31
+
+/**
+ * @brief Activa, desactiva o reprograma una alarma como miembro de un grupo.
+ *
+ * El grupo lo forman todas las alarmas de grupo con el mismo ID_evento. Las que
+ * vencen en la misma pasada de actualización se entregan como UN solo evento
+ * ID_evento con auxData = SVC_ALARMA_AUX_GRUPO | máscara, donde el bit 'miembro'
+ * está a 1 si ese miembro ha vencido.
+ * Una periódica que entra en un grupo donde ya hay otra periódica del mismo periodo
+ * se alinea a su fase, para que a partir de ahí venzan juntas.
+ *
+ * La alarma se identifica por (ID_evento, miembro), igual que una normal, así que
+ * se cancela o se convierte en normal con svc_alarma_activar(..., ID_evento, miembro).
+ *
+ * @param alarma_flags Flags codificados (svc_alarma_codificar). Si es 0, cancela la alarma.
+ * @param ID_evento El evento del grupo.
+ * @param miembro Índice del miembro dentro del grupo (0..SVC_ALARMA_GRUPO_MAX-1).
+ * @param holgura_ms Retraso máximo tolerado (ver svc_alarma_activar_holgura).
+ */
+void svc_alarma_activar_grupo(uint32_t alarma_flags, EVENTO_T ID_evento, uint8_t miembro, uint32_t holgura_ms);
+
+/**
+ * @brief Función de actualización del servicio de alarmas.
+ *
+ * La llama el Gestor de Eventos con cada despertar del servicio: dispara los eventos
+ * de las alarmas cuyo plazo ya ha pasado y programa el siguiente despertar.
  *
  * @param evento El evento de tick que ha saltado (debe ser el ev_a_notificar).
  * @param aux Datos auxiliares del evento (no se usan en esta función).
  */
 void svc_alarma_actualizar(EVENTO_T evento, uint32_t aux);
 
+/**
+ * @brief Activa o reprograma una alarma de resolución microsegundo.
+ *
+ * API paralela a svc_alarma_activar: el plazo es un instante absoluto de 64 bits
+ * sobre el reloj libre (drv_tiempo_actual_us) y el disparo lo hace el comparador
+ * hardware, sin pasar por la tabla en ms ni por el GE. Las periódicas se reprograman sumando
+ * el periodo al plazo anterior, por lo que no acumulan deriva.
+ * Se identifica por (ID_evento, auxData), igual que las alarmas en ms.
+ *
+ * @param deadline_us Instante absoluto (us) del primer vencimiento.
+ * @param periodo_us Periodo en microsegundos, 0 para alarma esporádica.
+ * @param ID_evento El evento a encolar cuando venza la alarma.
+ * @param auxData Datos auxiliares para dicho evento.
+ */
+void svc_alarma_activar_us(Tiempo_us_t deadline_us, Tiempo_us_t periodo_us, EVENTO_T ID_evento, uint32_t auxData);
+
+/**
+ * @brief Cancela una alarma en microsegundos (no hace nada si no existe).
+ */
+void svc_alarma_cancelar_us(EVENTO_T ID_evento, uint32_t auxData);
+
 
 #endif /* SVC_ALARMAS_H */
@@ -0,0 +1,285 @@
+/* *****************************************************************************
+ * P.H.2025: Almacén clave/valor en flash con nivelado de desgaste (formato en svc_almacen.h)
+ */
+#include "svc_almacen.h"
+#include "drv_flash.h"
+#include "drv_WDT.h"
+#include <string.h>
+
+#define CABECERA_PAGINA     8u                  // mágico + secuencia
+#define NINGUNA             0xFFFFFFFFu
+#define PALABRAS(len)       (((len) + 3u) / 4u)
+#define TAM_REGISTRO(len)   (4u + PALABRAS(len) * 4u + 4u)
+#define COMPACTAR_INTENTOS  2u                  // compactaciones fallidas seguidas antes de darla por averiada
+
+typedef struct {
+    uint8_t  clave;                 // 0: entrada libre
+    uint8_t  len;                   // 0 con pendiente: borrado aún sin volcar
+    bool     pendiente;             // datos[] aún no está en flash
+    uint32_t offset;                // byte del último registro válido en la página activa (0: ninguno)
+    uint8_t  datos[SVC_ALMACEN_DATOS_MAX];
+} entrada_t;
+
+static entrada_t s_tabla[SVC_ALMACEN_CLAVES];
+static uint32_t s_activa = NINGUNA;     // página activa
+static uint32_t s_secuencia = 0;
+static uint32_t s_libre = 0;            // primer byte libre de la página activa
+static bool s_diferir = false;
+static bool s_averiado = false;         // la flash no acepta escrituras: se deja de intentar
+static uint32_t s_fallos_compactar = 0; // compactaciones fallidas seguidas
+static uint32_t s_registro[1 + SVC_ALMACEN_DATOS_MAX / 4];
+
+#ifdef DEBUG
+// --- VARIABLES GLOBALES DE DEPURACIÓN (Sin static, con volatile) ---
+volatile uint32_t dbg_almacen_registros = 0;        // registros añadidos
+volatile uint32_t dbg_almacen_compactaciones = 0;   // = borrados de página
+volatile uint32_t dbg_almacen_descartados = 0;      // registros incompletos encontrados al arrancar
+#endif
+
+static uint16_t crc16(uint8_t clave, uint8_t len, const uint8_t *datos) {
+    uint16_t crc = 0xFFFF;
+    for (uint32_t i = 0; i < 2u + len; i++) {
+        uint8_t b = (i == 0) ? clave : (i == 1) ? len : datos[i - 2];
+        crc ^= (uint16_t)b << 8;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static const uint8_t *datos_en_flash(const entrada_t *e) {
+    return (const uint8_t *)drv_flash_pagina(s_activa) + e->offset + 4u;
+}
+
+static entrada_t *buscar(uint8_t clave, bool crear) {
+    entrada_t *libre = NULL;
+    for (uint32_t i = 0; i < SVC_ALMACEN_CLAVES; i++) {
+        if (s_tabla[i].clave == clave) return &s_tabla[i];
+        if (s_tabla[i].clave == 0 && libre == NULL) libre = &s_tabla[i];
+    }
+    if (crear && libre != NULL) {
+        libre->clave = clave;
+        libre->len = 0;
+        libre->pendiente = false;
+        libre->offset = 0;
+    }
+    return crear ? libre : NULL;
+}
+
+/* Recorre los registros de la página activa hasta el primer hueco o registro inválido */
+static void recorrer_activa(void) {
+    const uint32_t *pagina = drv_flash_pagina(s_activa);
+    uint32_t tam = drv_flash_tam_pagina();
+    uint32_t off = CABECERA_PAGINA;
+
+    while (off + 4u <= tam) {
+        uint32_t cab = pagina[off / 4];
+        if (cab == 0xFFFFFFFFu) break;
+
+        uint8_t clave = cab & 0xFFu;
+        uint8_t len = (cab >> 8) & 0xFFu;
+        const uint8_t *datos = (const uint8_t *)pagina + off + 4u;
+        if (clave == 0 || clave == 0xFFu || len > SVC_ALMACEN_DATOS_MAX
+            || off + TAM_REGISTRO(len) > tam
+            || pagina[(off + TAM_REGISTRO(len)) / 4 - 1] != SVC_ALMACEN_CONFIRMADO
+            || crc16(clave, len, datos) != (cab >> 16)) {
+            // Registro cortado a medias: lo que queda de página no es fiable, se compacta
+#ifdef DEBUG
+            dbg_almacen_descartados++;
+#endif
+            off = tam;
+            break;
+        }
+
+        if (len == 0) {
+            // Borrado: lo anterior de esa clave deja de valer
+            entrada_t *e = buscar(clave, false);
+            if (e != NULL) e->clave = 0;
+        } else {
+            entrada_t *e = buscar(clave, true);
+            if (e != NULL) {
+                e->len = len;
+                e->offset = off;
+            }
+        }
+        off += TAM_REGISTRO(len);
+    }
+    s_libre = off;
+}
+
+/* Escribe el registro de la entrada en (pagina, off): cabecera y datos, y luego la confirmación */
+static bool escribir_registro(uint32_t pagina, uint32_t off, const entrada_t *e) {
+    const uint8_t *datos = e->pendiente ? e->datos : datos_en_flash(e);
+    uint32_t palabras = PALABRAS(e->len);
+
+    s_registro[0] = e->clave | ((uint32_t)e->len << 8) | ((uint32_t)crc16(e->clave, e->len, datos) << 16);
+    if (palabras > 0) s_registro[palabras] = 0xFFFFFFFFu;   // relleno de la última palabra
+    memcpy(&s_registro[1], datos, e->len);
+
+    static const uint32_t confirmado = SVC_ALMACEN_CONFIRMADO;
+    return drv_flash_escribir(pagina, off, s_registro, 1u + palabras)
+        && drv_flash_escribir(pagina, off + 4u + palabras * 4u, &confirmado, 1u);
+}
+
+/* Copia los valores vigentes (pendientes incluidos) a la siguiente página y la activa */
+static bool compactar(void) {
+    uint32_t destino = (s_activa == NINGUNA) ? 0 : (s_activa + 1u) % drv_flash_paginas();
+    uint32_t nuevos[SVC_ALMACEN_CLAVES];
+    uint32_t off = CABECERA_PAGINA;
+
+    // Antes de borrar se anula el mágico: un borrado cortado no puede dejar una página
+    // a medio borrar que parezca válida
+    static const uint32_t anulado = 0;
+    if (drv_flash_pagina(destino)[0] == SVC_ALMACEN_MAGICO
+        && !drv_flash_escribir(destino, 0u, &anulado, 1u)) return false;
+    if (!drv_flash_borrar(destino)) return false;
+
+    for (uint32_t i = 0; i < SVC_ALMACEN_CLAVES; i++) {
+        const entrada_t *e = &s_tabla[i];
+        nuevos[i] = 0;
+        if (e->clave == 0 || e->len == 0 || (!e->pendiente && e->offset == 0)) continue;
+        if (!escribir_registro(destino, off, e)) return false;
+        nuevos[i] = off;
+        off += TAM_REGISTRO(e->len);
+    }
+
+    // Secuencia y, al final, el mágico: hasta aquí manda la página anterior
+    uint32_t secuencia = s_secuencia + 1u;
+    static const uint32_t magico = SVC_ALMACEN_MAGICO;
+    if (!drv_flash_escribir(destino, 4u, &secuencia, 1u)) return false;
+    if (!drv_flash_escribir(destino, 0u, &magico, 1u)) return false;
+
+    for (uint32_t i = 0; i < SVC_ALMACEN_CLAVES; i++) {
+        if (s_tabla[i].len == 0) s_tabla[i].clave = 0;   // borrado: no se ha copiado
+        s_tabla[i].offset = nuevos[i];
+        s_tabla[i].pendiente = false;
+    }
+    s_activa = destino;
+    s_secuencia = secuencia;
+    s_libre = off;
+#ifdef DEBUG
+    dbg_almacen_compactaciones++;
+#endif
+    return true;
+}
+
+static bool volcar_uno(void) {
+    entrada_t *e = NULL;
+    for (uint32_t i = 0; i < SVC_ALMACEN_CLAVES && e == NULL; i++) {
+        if (s_tabla[i].clave != 0 && s_tabla[i].pendiente) e = &s_tabla[i];
+    }
+    if (e == NULL) return false;
+
+    if (s_activa == NINGUNA || s_libre + TAM_REGISTRO(e->len) > drv_flash_tam_pagina()) {
+        // Un borrado por llamada: el reintento (vuelve a borrar el destino) va en la
+        // siguiente. Tras COMPACTAR_INTENTOS seguidos la flash no es utilizable.
+        if (compactar()) s_fallos_compactar = 0;
+        else if (++s_fallos_compactar >= COMPACTAR_INTENTOS) s_averiado = true;
+        return true;
+    }
+
+    if (escribir_registro(s_activa, s_libre, e)) {
+        e->offset = s_libre;
+        e->pendiente = false;
+        s_libre += TAM_REGISTRO(e->len);
+        if (e->len == 0) e->clave = 0;              // borrado ya en flash: entrada libre
+#ifdef DEBUG
+        dbg_almacen_registros++;
+#endif
+    } else {
+        s_libre = drv_flash_tam_pagina();           // la próxima vez, a una página limpia
+    }
+    return true;
+}
+
+uint32_t svc_almacen_iniciar(void) {
+    memset(s_tabla, 0, sizeof(s_tabla));
+    s_activa = NINGUNA;
+    s_secuencia = 0;
+    s_libre = 0;
+    s_diferir = false;
+    s_averiado = false;
+    s_fallos_compactar = 0;
+
+    for (uint32_t p = 0; p < drv_flash_paginas(); p++) {
+        const uint32_t *pagina = drv_flash_pagina(p);
+        if (pagina[0] != SVC_ALMACEN_MAGICO) continue;
+        if (s_activa == NINGUNA || (int32_t)(pagina[1] - s_secuencia) > 0) {
+            s_activa = p;
+            s_secuencia = pagina[1];
+        }
+    }
+    if (s_activa == NINGUNA) return 0;
+
+    recorrer_activa();
+    uint32_t claves = 0;
+    for (uint32_t i = 0; i < SVC_ALMACEN_CLAVES; i++) {
+        if (s_tabla[i].clave != 0) claves++;
+    }
+    return claves;
+}
+
+uint32_t svc_almacen_leer(uint8_t clave, void *datos, uint32_t max) {
+    const entrada_t *e = buscar(clave, false);
+    if (e == NULL || e->len == 0) return 0;
+
+    uint32_t n = (e->len < max) ? e->len : max;
+    memcpy(datos, e->pendiente ? e->datos : datos_en_flash(e), n);
+    return n;
+}
+
+bool svc_almacen_guardar(uint8_t clave, const void *datos, uint32_t len) {
+    if (clave == 0 || clave == 0xFFu || len == 0 || len > SVC_ALMACEN_DATOS_MAX) return false;
+
+    entrada_t *e = buscar(clave, true);
+    if (e == NULL) return false;
+
+    // Mismo valor que en flash: no se gasta flash
+    if (!e->pendiente && e->offset != 0 && e->len == len && memcmp(datos_en_flash(e), datos, len) == 0) {
+        e->pendiente = false;
+        return true;
+    }
+    memcpy(e->datos, datos, len);
+    e->len = (uint8_t)len;
+    e->pendiente = true;
+    return true;
+}
+
+bool svc_almacen_borrar(uint8_t clave) {
+    entrada_t *e = buscar(clave, false);
+    if (clave == 0 || e == NULL) return false;
+
+    if (e->offset == 0) {
+        // Nunca llegó a flash: basta con olvidarla
+        e->clave = 0;
+        e->pendiente = false;
+        return true;
+    }
+    e->len = 0;
+    e->pendiente = true;
+    return true;
+}
+
+bool svc_almacen_pendiente(void) {
+    for (uint32_t i = 0; i < SVC_ALMACEN_CLAVES; i++) {
+        if (s_tabla[i].clave != 0 && s_tabla[i].pendiente) return true;
+    }
+    return false;
+}
+
+void svc_almacen_diferir(bool diferir) {
+    s_diferir = diferir;
+}
+
+bool svc_almacen_volcar(void) {
+    if (s_diferir || s_averiado) return false;
+    return volcar_uno();
+}
+
+void svc_almacen_volcar_todo(void) {
+    // Cada vuelta puede borrar una página (~400 ms en LPC): el perro no llega a saltar
+    while (!s_averiado && volcar_uno()) {
+        drv_WDT_alimentar();
+    }
+}
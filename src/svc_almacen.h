@@ -0,0 +1,66 @@
+#ifndef SVC_ALMACEN_H
+#define SVC_ALMACEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* -----------------------------------------------------------------------------
+ * Almacén clave/valor persistente en la región de flash reservada (drv_flash).
+ *
+ * Registro de solo-añadir: cada escritura añade un registro al final de la página
+ * activa y el valor vigente de una clave es su último registro válido. Con la página
+ * llena, los valores vigentes se compactan en la siguiente página de la región
+ * (rotación: todas las páginas se borran por igual).
+ *
+ * Formato de página:
+ *   palabra 0: SVC_ALMACEN_MAGICO   (se escribe la última: confirma la compactación)
+ *   palabra 1: secuencia            (la página válida con mayor secuencia es la activa)
+ *   registros: [clave | long << 8 | crc16 << 16] [datos, rellenos a 4 con 0xFF] [SVC_ALMACEN_CONFIRMADO]
+ *   (long 0, sin datos: la clave se ha borrado)
+ *
+ * Un corte de alimentación a mitad de un registro deja su palabra de confirmación en
+ * blanco: al arrancar se ignora junto con lo que le siga y la próxima escritura compacta.
+ * A mitad de una compactación, la página nueva aún no tiene mágico y sigue valiendo la anterior.
+ *
+ * Las escrituras no tocan la flash: se guardan en RAM y se vuelcan en los huecos
+ * ociosos del despachador (svc_almacen_volcar). Borrar una página para la CPU
+ * (~85 ms nRF, ~400 ms LPC): mientras svc_almacen_diferir(true), no se vuelca nada.
+ */
+#define SVC_ALMACEN_CLAVES      4      // claves distintas que caben en el almacén
+#define SVC_ALMACEN_DATOS_MAX   64     // bytes por valor
+
+#define SVC_ALMACEN_MAGICO      0x314D4C41u   // "ALM1"
+#define SVC_ALMACEN_CONFIRMADO  0x4B4F4B4Fu   // "OKOK"
+
+/* Busca la página activa y recorre su registro. Sin página válida el almacén está
+ * vacío y la primera escritura da formato. Devuelve el número de claves encontradas. */
+uint32_t svc_almacen_iniciar(void);
+
+/* Copia el valor vigente de la clave (1..254), incluido uno pendiente de volcar.
+ * Devuelve los bytes copiados (como mucho max), 0 si la clave no existe. */
+uint32_t svc_almacen_leer(uint8_t clave, void *datos, uint32_t max);
+
+/* Deja el valor pendiente de volcar. Si coincide con el que ya está en flash no se
+ * escribe nada. Devuelve false si la clave o la longitud no valen o no caben más claves. */
+bool svc_almacen_guardar(uint8_t clave, const void *datos, uint32_t len);
+
+/* Borra la clave. Como guardar, solo en RAM: en flash queda un registro de long 0 al
+ * volcar (o deja de copiarse al compactar). Devuelve false si la clave no existe. */
+bool svc_almacen_borrar(uint8_t clave);
+
+/* true mientras quede algún valor sin volcar */
+bool svc_almacen_pendiente(void);
+
+/* Mientras diferir sea true, svc_almacen_volcar no escribe (p.ej. durante una partida) */
+void svc_almacen_diferir(bool diferir);
+
+/* Vuelca como mucho un registro (o un intento de compactación). Para el bucle ocioso:
+ * devuelve true si ha escrito algo y conviene volver a mirar la cola antes de dormir. */
+bool svc_almacen_volcar(void);
+
+/* Vuelca todo lo pendiente aunque esté diferido (antes de apagar). Alimenta al perro
+ * entre borrados de página. */
+void svc_almacen_volcar_todo(void);
+
+#endif /* SVC_ALMACEN_H */
@@ -0,0 +1,210 @@
+/* *****************************************************************************
+ * P.H.2025: Servicio de gestos sobre los botones
+ *
+ * Reconoce pulsación larga, doble toque, acordes y autorrepetición a partir de
+ * las pulsaciones y soltados ya filtrados por drv_botones. Todos los plazos
+ * pendientes se guardan en absoluto (ms) y una única alarma de svc_alarmas se
+ * reprograma siempre al más cercano.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "svc_gestos.h"
+#include "svc_alarmas.h"
+#include "drv_botones.h"
+#include "drv_tiempo.h"
+#include "rt_GE.h"
+
+#define svc_GESTOS_BOTONES_MAX 8
+
+// Umbrales por defecto (ms)
+#define LARGA_MS_DEF            800
+#define DOBLE_MS_DEF            300
+#define ACORDE_MS_DEF           60
+#define REPETIR_INICIO_MS_DEF   500
+#define REPETIR_PERIODO_MS_DEF  150
+
+static void (*m_cb_a_llamar)(uint32_t, uint32_t);
+static EVENTO_T m_ev_pulsar;
+static EVENTO_T m_ev_soltar;
+static EVENTO_T m_ev_gesto;
+static EVENTO_T m_ev_timer;
+
+static svc_gestos_config_t m_config = {
+    LARGA_MS_DEF, DOBLE_MS_DEF, ACORDE_MS_DEF, REPETIR_INICIO_MS_DEF, REPETIR_PERIODO_MS_DEF
+};
+
+// Estado por botón (bit i = botón i)
+static uint32_t m_pulsados;
+static uint32_t m_pend_larga;                   // larga por vencer
+static uint32_t m_pend_repetir;                 // repetición por vencer
+static uint32_t m_hay_anterior;                 // pulsación candidata a primer toque del doble
+static Tiempo_ms_t m_venc_larga[svc_GESTOS_BOTONES_MAX];
+static Tiempo_ms_t m_venc_repetir[svc_GESTOS_BOTONES_MAX];
+static Tiempo_ms_t m_pulsacion_anterior[svc_GESTOS_BOTONES_MAX];
+
+// Acorde abierto: botones pulsados desde la primera hasta el cierre de la ventana
+static bool m_acorde_abierto;
+static uint32_t m_acorde_mascara;
+static Tiempo_ms_t m_acorde_venc;
+
+#ifdef DEBUG
+volatile uint32_t dbg_gestos_emitidos = 0;
+volatile uint32_t dbg_gestos_reprogramaciones = 0;
+#endif
+
+// Plazo alcanzado (aritmética modular, como el resto de instantes en ms)
+static inline bool vencido(Tiempo_ms_t venc, Tiempo_ms_t ahora) {
+    return (int32_t)(ahora - venc) >= 0;
+}
+
+static void emitir(svc_gesto_t tipo, uint32_t dato) {
+#ifdef DEBUG
+    dbg_gestos_emitidos++;
+#endif
+    m_cb_a_llamar(m_ev_gesto, SVC_GESTO_AUX(tipo, dato));
+}
+
+static uint8_t contar_bits(uint32_t m) {
+    uint8_t n = 0;
+    while (m) { m &= m - 1; n++; }
+    return n;
+}
+
+// Vence lo que toque y deja la alarma única en el plazo pendiente más cercano
+static void procesar(Tiempo_ms_t ahora) {
+    bool hay = false;
+    Tiempo_ms_t proximo = 0;
+
+    for (uint8_t i = 0; i < svc_GESTOS_BOTONES_MAX; i++) {
+        uint32_t bit = 1u << i;
+
+        if ((m_pend_larga & bit) && vencido(m_venc_larga[i], ahora)) {
+            m_pend_larga &= ~bit;
+            emitir(SVC_GESTO_LARGA, i);
+        }
+        if ((m_pend_repetir & bit) && vencido(m_venc_repetir[i], ahora)) {
+            emitir(SVC_GESTO_REPETIR, i);
+            if (m_config.repetir_periodo_ms == 0) {
+                m_pend_repetir &= ~bit;
+            } else {
+                // Sobre el plazo, no sobre ahora; si el GE se retrasó mucho, no ráfagas
+                m_venc_repetir[i] += m_config.repetir_periodo_ms;
+                if (vencido(m_venc_repetir[i], ahora)) m_venc_repetir[i] = ahora + m_config.repetir_periodo_ms;
+            }
+        }
+
+        if ((m_pend_larga & bit) && (!hay || (int32_t)(m_venc_larga[i] - proximo) < 0)) {
+            proximo = m_venc_larga[i];
+            hay = true;
+        }
+        if ((m_pend_repetir & bit) && (!hay || (int32_t)(m_venc_repetir[i] - proximo) < 0)) {
+            proximo = m_venc_repetir[i];
+            hay = true;
+        }
+    }
+
+    if (m_acorde_abierto && vencido(m_acorde_venc, ahora)) {
+        m_acorde_abierto = false;
+        if (contar_bits(m_acorde_mascara) >= 2) {
+            emitir(SVC_GESTO_ACORDE, m_acorde_mascara);
+        }
+    }
+    if (m_acorde_abierto && (!hay || (int32_t)(m_acorde_venc - proximo) < 0)) {
+        proximo = m_acorde_venc;
+        hay = true;
+    }
+
+#ifdef DEBUG
+    dbg_gestos_reprogramaciones++;
+#endif
+    if (!hay) {
+        svc_alarma_activar(0, m_ev_timer, 0);
+    } else {
+        int32_t falta = (int32_t)(proximo - ahora);
+        if (falta < 1) falta = 1;
+        svc_alarma_activar(svc_alarma_codificar(false, (uint32_t)falta, 0), m_ev_timer, 0);
+    }
+}
+
+static void pulsar(uint8_t boton, Tiempo_ms_t t) {
+    uint32_t bit = 1u << boton;
+    m_pulsados |= bit;
+
+    if (m_config.doble_ms && (m_hay_anterior & bit) &&
+        (uint32_t)(t - m_pulsacion_anterior[boton]) <= m_config.doble_ms) {
+        m_hay_anterior &= ~bit;     // un tercer toque empieza otro doble
+        emitir(SVC_GESTO_DOBLE, boton);
+    } else {
+        m_pulsacion_anterior[boton] = t;
+        m_hay_anterior |= bit;
+    }
+
+    if (m_config.larga_ms) {
+        m_venc_larga[boton] = t + m_config.larga_ms;
+        m_pend_larga |= bit;
+    }
+    if (m_config.repetir_inicio_ms) {
+        m_venc_repetir[boton] = t + m_config.repetir_inicio_ms;
+        m_pend_repetir |= bit;
+    }
+
+    if (m_config.acorde_ms) {
+        if (m_acorde_abierto && !vencido(m_acorde_venc, t)) {
+            m_acorde_mascara |= bit;
+        } else {
+            m_acorde_abierto = true;
+            m_acorde_mascara = bit;
+            m_acorde_venc = t + m_config.acorde_ms;
+        }
+    }
+}
+
+static void soltar(uint8_t boton) {
+    uint32_t bit = 1u << boton;
+    m_pulsados &= ~bit;
+    m_pend_larga &= ~bit;
+    m_pend_repetir &= ~bit;
+}
+
+void svc_gestos_iniciar(void(*funcion_callback_app)(uint32_t, uint32_t),
+                        EVENTO_T ev_pulsar, EVENTO_T ev_soltar,
+                        EVENTO_T ev_gesto, EVENTO_T ev_timer) {
+    m_cb_a_llamar = funcion_callback_app;
+    m_ev_pulsar = ev_pulsar;
+    m_ev_soltar = ev_soltar;
+    m_ev_gesto = ev_gesto;
+    m_ev_timer = ev_timer;
+
+    m_pulsados = 0;
+    m_pend_larga = 0;
+    m_pend_repetir = 0;
+    m_hay_anterior = 0;
+    m_acorde_abierto = false;
+
+    rt_GE_suscribir(ev_pulsar, 0, svc_gestos_actualizar);
+    rt_GE_suscribir(ev_soltar, 0, svc_gestos_actualizar);
+    rt_GE_suscribir(ev_timer, 0, svc_gestos_actualizar);
+}
+
+void svc_gestos_configurar(const svc_gestos_config_t *config) {
+    if (config != NULL) m_config = *config;
+}
+
+void svc_gestos_actualizar(EVENTO_T evento, uint32_t auxData) {
+    Tiempo_ms_t ahora = drv_tiempo_actual_ms();
+
+    if (evento == m_ev_pulsar || evento == m_ev_soltar) {
+        if (auxData >= svc_GESTOS_BOTONES_MAX) return;
+        uint8_t boton = (uint8_t)auxData;
+
+        if (evento == m_ev_pulsar) {
+            // Los plazos cuentan desde el flanco real, no desde la confirmación
+            Tiempo_ms_t t = drv_tiempo_us_a_ms(drv_botones_marca_pulsacion(boton));
+            pulsar(boton, t);
+        } else {
+            soltar(boton);
+        }
+    }
+    procesar(ahora);
+}
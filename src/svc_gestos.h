@@ -0,0 +1,59 @@
+#ifndef SVC_GESTOS_H
+#define SVC_GESTOS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "rt_evento_t.h"
+
+/* Tipos de gesto (campo tipo del auxData de ev_gesto) */
+typedef enum {
+    SVC_GESTO_LARGA    = 1,  // botón mantenido larga_ms              (dato = botón)
+    SVC_GESTO_DOBLE    = 2,  // segunda pulsación en doble_ms         (dato = botón)
+    SVC_GESTO_ACORDE   = 3,  // 2+ botones pulsados en acorde_ms      (dato = máscara)
+    SVC_GESTO_REPETIR  = 4   // autorrepetición mientras se mantiene  (dato = botón)
+} svc_gesto_t;
+
+/* auxData = tipo << 16 | dato */
+#define SVC_GESTO_AUX(tipo, dato)  (((uint32_t)(tipo) << 16) | ((uint32_t)(dato) & 0xFFFFu))
+#define SVC_GESTO_TIPO(aux)        ((svc_gesto_t)((aux) >> 16))
+#define SVC_GESTO_DATO(aux)        ((aux) & 0xFFFFu)
+
+/* Umbrales en ms; 0 desactiva ese gesto */
+typedef struct {
+    uint32_t larga_ms;             // pulsación larga
+    uint32_t doble_ms;             // máximo entre dos pulsaciones para doble toque
+    uint32_t acorde_ms;            // ventana desde la primera pulsación del acorde
+    uint32_t repetir_inicio_ms;    // primera repetición
+    uint32_t repetir_periodo_ms;   // siguientes repeticiones
+} svc_gestos_config_t;
+
+/**
+ * @brief Inicializa el servicio de gestos sobre los eventos del driver de botones.
+ *
+ * Se suscribe a las pulsaciones/soltados confirmados y genera ev_gesto cuando se
+ * reconoce un gesto. Todos los plazos pendientes (larga, repetición, cierre de acorde)
+ * comparten UNA sola alarma, reprogramada al más cercano: el número de gestos en curso
+ * no consume slots de svc_alarmas.
+ *
+ * @param funcion_callback_app Función para encolar eventos (ej. rt_FIFO_encolar).
+ * @param ev_pulsar  Pulsación confirmada (ev_PULSAR_BOTON).
+ * @param ev_soltar  Soltado confirmado (ev_SOLTAR_BOTON).
+ * @param ev_gesto   Evento a generar, auxData = SVC_GESTO_AUX(tipo, dato).
+ * @param ev_timer   Evento de la alarma interna del servicio.
+ */
+void svc_gestos_iniciar(void(*funcion_callback_app)(uint32_t, uint32_t),
+                        EVENTO_T ev_pulsar, EVENTO_T ev_soltar,
+                        EVENTO_T ev_gesto, EVENTO_T ev_timer);
+
+/**
+ * @brief Cambia los umbrales (se aplican a los gestos que empiecen a partir de ahora).
+ */
+void svc_gestos_configurar(const svc_gestos_config_t *config);
+
+/**
+ * @brief Callback de suscripción: pulsaciones, soltados y la alarma interna.
+ */
+void svc_gestos_actualizar(EVENTO_T evento, uint32_t auxData);
+
+#endif /* SVC_GESTOS_H */
@@ -0,0 +1,58 @@
+/* *****************************************************************************
+ * P.H.2025: Lector de partituras en flash (formato en svc_partitura.h)
+ */
+#include "svc_partitura.h"
+
+void svc_partitura_abrir(svc_partitura_cursor_t *cursor, const svc_partitura_t *partitura,
+                         uint16_t paso_ms_defecto) {
+    cursor->pos = partitura->datos;
+    cursor->fin = partitura->datos + partitura->tam;
+    cursor->carriles = 0;
+    cursor->pendientes = 0;
+    cursor->nivel = 1;
+    cursor->paso_ms = paso_ms_defecto;
+}
+
+bool svc_partitura_siguiente(svc_partitura_cursor_t *cursor, uint8_t *carriles) {
+    // Quedan repeticiones del ultimo paso (RLE o ALEATORIO)
+    if (cursor->pendientes > 0) {
+        cursor->pendientes--;
+        *carriles = cursor->carriles;
+        return true;
+    }
+
+    while (cursor->pos < cursor->fin) {
+        uint8_t b = *cursor->pos++;
+
+        if ((b & 0x80u) == 0) {
+            cursor->carriles = b & SVC_PARTITURA_CARRILES;
+            cursor->pendientes = b >> SVC_PARTITURA_PASO_REP_POS;
+            *carriles = cursor->carriles;
+            return true;
+        }
+
+        switch (b & 0xF0u) {
+            case SVC_PARTITURA_TEMPO:
+                if (cursor->fin - cursor->pos < 2) return false;
+                cursor->paso_ms = (uint16_t)(cursor->pos[0] | (cursor->pos[1] << 8));
+                cursor->pos += 2;
+                break;
+
+            case SVC_PARTITURA_SECCION:
+                cursor->nivel = b & 0x0Fu;
+                break;
+
+            case SVC_PARTITURA_ALEATORIO:
+                cursor->carriles = SVC_PARTITURA_PASO_ALEATORIO;
+                cursor->pendientes = b & 0x0Fu;
+                *carriles = SVC_PARTITURA_PASO_ALEATORIO;
+                return true;
+
+            case SVC_PARTITURA_FIN:
+            default:
+                cursor->pos = cursor->fin;
+                return false;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,70 @@
+#ifndef SVC_PARTITURA_H
+#define SVC_PARTITURA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* -----------------------------------------------------------------------------
+ * Partituras de Beat Hero en flash: un flujo de bytes const que se recorre paso a
+ * paso sin copiarlo a RAM. Las genera tools/partitura.py a partir de texto.
+ *
+ * Formato (un byte por entrada):
+ *   0rrr cccc              PASO: carriles cccc (bit n = carril n), repetido rrr+1 veces;
+ *                          Beat Hero solo usa los carriles 0 y 1
+ *   1000 0000              FIN
+ *   1001 0000  lo hi       TEMPO: duracion de paso en ms (16 bits, little endian)
+ *   1010 nnnn              SECCION: nivel de dificultad nnnn a partir de aqui
+ *   1011 kkkk              ALEATORIO: kkkk+1 pasos que genera el juego (a su nivel)
+ */
+#define SVC_PARTITURA_PASO_REP_POS  4
+#define SVC_PARTITURA_CARRILES      0x0Fu
+
+#define SVC_PARTITURA_FIN           0x80u
+#define SVC_PARTITURA_TEMPO         0x90u
+#define SVC_PARTITURA_SECCION       0xA0u
+#define SVC_PARTITURA_ALEATORIO     0xB0u
+
+/* Valor de carriles de un paso que el juego debe generar (ALEATORIO) */
+#define SVC_PARTITURA_PASO_ALEATORIO 0xFFu
+
+/* Partitura en flash */
+typedef struct {
+    const char    *nombre;
+    const uint8_t *datos;
+    uint16_t       tam;
+} svc_partitura_t;
+
+/* Posicion de lectura (lo unico que vive en RAM) */
+typedef struct {
+    const uint8_t *pos;
+    const uint8_t *fin;
+    uint8_t  carriles;      // paso que se esta repitiendo
+    uint8_t  pendientes;    // repeticiones que quedan de ese paso
+    uint8_t  nivel;         // ultima SECCION leida
+    uint16_t paso_ms;       // ultimo TEMPO leido
+} svc_partitura_cursor_t;
+
+/**
+ * @brief Coloca el cursor al principio de una partitura.
+ *
+ * @param paso_ms_defecto Duracion de paso hasta el primer TEMPO.
+ */
+void svc_partitura_abrir(svc_partitura_cursor_t *cursor, const svc_partitura_t *partitura,
+                         uint16_t paso_ms_defecto);
+
+/**
+ * @brief Lee el siguiente paso, aplicando antes los TEMPO/SECCION que lo preceden.
+ *
+ * Coste constante por paso (salvo comandos encadenados): no hay tablas en RAM.
+ *
+ * @param carriles Mascara de notas del paso, o SVC_PARTITURA_PASO_ALEATORIO.
+ * @return false al llegar a FIN (o al final de los datos).
+ */
+bool svc_partitura_siguiente(svc_partitura_cursor_t *cursor, uint8_t *carriles);
+
+/* Partituras incluidas en el firmware (src/partituras.c, generado) */
+extern const svc_partitura_t g_partituras[];
+extern const uint8_t g_num_partituras;
+
+#endif /* SVC_PARTITURA_H */
@@ -0,0 +1,41 @@
+/* *****************************************************************************
+ * P.H.2025: Coma fija Q16.16 (tempo y escalados del juego sin float)
+ */
+#include "svc_q16.h"
+
+#define US_POR_MINUTO 60000000ULL
+
+q16_t q16_ratio(uint32_t num, uint32_t den) {
+    if (den == 0) return INT32_MAX;
+    return (q16_t)(((uint64_t)num << 16) / den);
+}
+
+void q16_tempo_bpm(q16_tempo_t *tempo, q16_t bpm) {
+    // (60e6 us << 32) / (bpm << 16) = (60e6 / bpm) << 16; 60e6 < 2^26, cabe en 64 bits
+    tempo->periodo_us_q16 = (bpm > 0) ? (US_POR_MINUTO << 32) / (uint32_t)bpm : 0;
+    tempo->acumulado_q16 = 0;
+}
+
+void q16_tempo_periodo_us(q16_tempo_t *tempo, uint32_t periodo_us) {
+    tempo->periodo_us_q16 = (uint64_t)periodo_us << 16;
+    tempo->acumulado_q16 = 0;
+}
+
+void q16_tempo_escalar(q16_tempo_t *tempo, q16_t factor) {
+    // periodo (<= 2^42 en Q16) * factor (< 2^31) no cabe en 64 bits: en dos mitades
+    uint64_t alto = (tempo->periodo_us_q16 >> 16) * (uint32_t)factor;
+    uint64_t bajo = ((tempo->periodo_us_q16 & 0xFFFFu) * (uint32_t)factor) >> 16;
+    tempo->periodo_us_q16 = alto + bajo;
+}
+
+uint32_t q16_tempo_siguiente_us(q16_tempo_t *tempo) {
+    tempo->acumulado_q16 += (uint32_t)(tempo->periodo_us_q16 & 0xFFFFu);
+    uint32_t arrastre = tempo->acumulado_q16 >> 16;
+    tempo->acumulado_q16 &= 0xFFFFu;
+    return (uint32_t)(tempo->periodo_us_q16 >> 16) + arrastre;
+}
+
+q16_t q16_tempo_a_bpm(const q16_tempo_t *tempo) {
+    if (tempo->periodo_us_q16 == 0) return 0;
+    return (q16_t)((US_POR_MINUTO << 32) / tempo->periodo_us_q16);
+}
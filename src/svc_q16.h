@@ -0,0 +1,64 @@
+#ifndef SVC_Q16_H
+#define SVC_Q16_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* -----------------------------------------------------------------------------
+ * Coma fija Q16.16 para la lógica de juego: el LPC2105 (ARM7) no tiene FPU y un
+ * float/double en el camino del juego arrastra las rutinas software de libgcc/microlib.
+ * Un producto Q16 es un UMULL/SMULL (64 bits) y un desplazamiento.
+ */
+typedef int32_t q16_t;
+
+#define Q16_UNO             ((q16_t)0x10000)
+/* Con producto y no con << 16: desplazar un negativo a la izquierda es UB en C */
+#define Q16_ENTERO(n)       ((q16_t)((n) * Q16_UNO))
+/* Fracción num/den como constante (se resuelve al compilar, sin float) */
+#define Q16_FRAC(num, den)  ((q16_t)(((int64_t)(num) * Q16_UNO) / (den)))
+
+/* a*b en Q16 */
+static inline q16_t q16_mul(q16_t a, q16_t b) {
+    return (q16_t)(((int64_t)a * b) >> 16);
+}
+
+/* Parte entera (trunca hacia -inf) */
+static inline int32_t q16_entero(q16_t a) {
+    return a >> 16;
+}
+
+/* Escala un entero sin signo por un factor Q16 positivo: v * f (trunca) */
+static inline uint32_t q16_escalar(uint32_t v, q16_t f) {
+    return (uint32_t)(((uint64_t)v * (uint32_t)f) >> 16);
+}
+
+/* num/den en Q16 (una división; para precalcular factores fuera del camino caliente) */
+q16_t q16_ratio(uint32_t num, uint32_t den);
+
+
+/* --- Tempo ---
+ * Periodo de un pulso en us con 16 bits de fracción. Los us sueltos que no caben en un
+ * periodo entero se acumulan y se devuelven en el pulso que completan, así una
+ * secuencia de pulsos no deriva aunque 60 s / BPM no sea un número exacto de us. */
+typedef struct {
+    uint64_t periodo_us_q16;    // us por pulso << 16
+    uint32_t acumulado_q16;     // fracción arrastrada (< Q16_UNO)
+} q16_tempo_t;
+
+/* Tempo a partir de BPM en Q16 (admite BPM fraccionarios) */
+void q16_tempo_bpm(q16_tempo_t *tempo, q16_t bpm);
+
+/* Tempo a partir de un periodo entero en us */
+void q16_tempo_periodo_us(q16_tempo_t *tempo, uint32_t periodo_us);
+
+/* Multiplica el periodo por un factor Q16 (p.ej. Q16_FRAC(9, 10) = 10% más rápido) */
+void q16_tempo_escalar(q16_tempo_t *tempo, q16_t factor);
+
+/* us hasta el siguiente pulso (periodo entero + el us acumulado si se completa) */
+uint32_t q16_tempo_siguiente_us(q16_tempo_t *tempo);
+
+/* BPM equivalentes en Q16 */
+q16_t q16_tempo_a_bpm(const q16_tempo_t *tempo);
+
+#endif /* SVC_Q16_H */
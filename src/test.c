@@ -15,6 +15,8 @@
 #include "drv_leds.h"
 #include "drv_tiempo.h"
 #include "drv_monitor.h"
+#include "svc_q16.h"
+#include "svc_almacen.h"
 #include "rt_evento_t.h"
 
 // --- VARIABLES GLOBALES PARA TESTS ---
@@ -143,19 +145,172 @@ bool test_alarmas(void) {
     return true;
 }
 
+/* =============================================================================
+ * TEST 3b: CONVERSIÓN DE TIEMPO (recíproco vs división)
+ * ===========================================================================*/
+#define BENCH_ITERACIONES 1000
+
+#ifdef DEBUG
+// Ciclos por llamada (descontado el bucle vacío)
+volatile uint32_t dbg_bench_ciclos_division = 0;
+volatile uint32_t dbg_bench_ciclos_reciproco = 0;
+#endif
+
+// volatile: obliga a una división de 64 bits real en tiempo de ejecución
+static volatile uint32_t s_bench_divisor = TIMER_TICKS_PER_US;
+static volatile uint64_t s_bench_sumidero;
+
+bool test_conversion_tiempo(void) {
+    // Exactitud en bordes de división y valores grandes
+    const uint64_t casos[] = { 0, 1, TIMER_TICKS_PER_US - 1, TIMER_TICKS_PER_US,
+                               0xFFFFFFFFull, 0x100000000ull * TIMER_TICKS_PER_US - 1,
+                               0x0123456789ABCDEFull, 0x0FFFFFFFFFFFFFFFull };
+    for (uint32_t i = 0; i < sizeof(casos) / sizeof(casos[0]); i++) {
+        if (drv_tiempo_ticks_a_us(casos[i]) != casos[i] / s_bench_divisor) return false;
+    }
+
+    #ifdef DEBUG
+    uint64_t t = 0x0000123456789ABCull;
+    Tiempo_us_t t0 = drv_tiempo_actual_us();
+    for (uint32_t i = 0; i < BENCH_ITERACIONES; i++) s_bench_sumidero = t + i;
+    Tiempo_us_t t1 = drv_tiempo_actual_us();
+    for (uint32_t i = 0; i < BENCH_ITERACIONES; i++) s_bench_sumidero = (t + i) / s_bench_divisor;
+    Tiempo_us_t t2 = drv_tiempo_actual_us();
+    for (uint32_t i = 0; i < BENCH_ITERACIONES; i++) s_bench_sumidero = drv_tiempo_ticks_a_us(t + i);
+    Tiempo_us_t t3 = drv_tiempo_actual_us();
+
+    uint32_t vacio = (uint32_t)(t1 - t0);
+    dbg_bench_ciclos_division  = ((uint32_t)(t2 - t1) - vacio) * CPU_CLOCK_MHZ / BENCH_ITERACIONES;
+    dbg_bench_ciclos_reciproco = ((uint32_t)(t3 - t2) - vacio) * CPU_CLOCK_MHZ / BENCH_ITERACIONES;
+    #endif
+    return true;
+}
+
+/* =============================================================================
+ * TEST 3c: COMA FIJA Q16.16 (sustituye al float del juego)
+ * ===========================================================================*/
+#ifdef DEBUG
+// Ciclos por llamada: escalado con double (lo que habia en app_jugar) y con Q16
+volatile uint32_t dbg_bench_ciclos_double = 0;
+volatile uint32_t dbg_bench_ciclos_q16 = 0;
+#endif
+
+static volatile uint32_t s_bench_retardo = 1000;
+static volatile uint32_t s_bench_sumidero32;
+
+bool test_coma_fija(void) {
+    if (q16_mul(Q16_ENTERO(3), Q16_FRAC(1, 2)) != Q16_FRAC(3, 2)) return false;
+    if (q16_mul(Q16_ENTERO(-2), Q16_FRAC(3, 4)) != -Q16_FRAC(3, 2)) return false;
+    if (q16_escalar(1000, Q16_FRAC(1, 2)) != 500) return false;
+
+    // 60 s / 7 BPM no es un número entero de us: 7 pulsos deben sumar 60 s (±1 us)
+    q16_tempo_t tempo;
+    q16_tempo_bpm(&tempo, Q16_ENTERO(7));
+    uint32_t suma = 0;
+    for (int i = 0; i < 7; i++) suma += q16_tempo_siguiente_us(&tempo);
+    if (suma + 1 < 60000000u || suma > 60000001u) return false;
+
+    // Acelerar un 10% un compás de 1 s (0.9 en Q16 trunca 0.4/65536: ~6 us)
+    q16_tempo_periodo_us(&tempo, 1000000u);
+    q16_tempo_escalar(&tempo, Q16_FRAC(9, 10));
+    uint32_t p = q16_tempo_siguiente_us(&tempo);
+    if (p + 10 < 900000u || p > 900000u) return false;
+    if (q16_entero(q16_tempo_a_bpm(&tempo)) != 66) return false;   // 66.6 BPM
+
+    #ifdef DEBUG
+    Tiempo_us_t t0 = drv_tiempo_actual_us();
+    for (uint32_t i = 0; i < BENCH_ITERACIONES; i++) s_bench_sumidero32 = s_bench_retardo + i;
+    Tiempo_us_t t1 = drv_tiempo_actual_us();
+    for (uint32_t i = 0; i < BENCH_ITERACIONES; i++) s_bench_sumidero32 = (uint32_t)((s_bench_retardo + i) * 0.95);
+    Tiempo_us_t t2 = drv_tiempo_actual_us();
+    for (uint32_t i = 0; i < BENCH_ITERACIONES; i++) s_bench_sumidero32 = q16_escalar(s_bench_retardo + i, Q16_FRAC(95, 100));
+    Tiempo_us_t t3 = drv_tiempo_actual_us();
+
+    uint32_t vacio = (uint32_t)(t1 - t0);
+    dbg_bench_ciclos_double = ((uint32_t)(t2 - t1) - vacio) * CPU_CLOCK_MHZ / BENCH_ITERACIONES;
+    dbg_bench_ciclos_q16    = ((uint32_t)(t3 - t2) - vacio) * CPU_CLOCK_MHZ / BENCH_ITERACIONES;
+    #endif
+    return true;
+}
+
 /* =============================================================================
  * TEST 4: SECCIÓN CRÍTICA
  * ===========================================================================*/
+#ifdef DEBUG
+static uint32_t secciones_medidas(void) {
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < DRV_SC_HIST; i++) total += dbg_sc_hist[i];
+    return total;
+}
+#endif
+
 bool test_seccion_critica(void) {
-    drv_SC_entrar_disable_irq();
+    uint32_t sc = drv_SC_entrar_disable_irq();
+    #ifdef DEBUG
+    // Dentro de la sección no entra ninguna ISR que pueda sumar otra medida
+    uint32_t antes = secciones_medidas();
+    #endif
     volatile int x = 0; 
     x++;
-    drv_SC_salir_enable_irq();
+    // Anidada: restaura el estado de la exterior, que sigue bloqueada
+    uint32_t sc2 = drv_SC_entrar_disable_irq();
+    x++;
+    drv_SC_salir_enable_irq(sc2);
+    #ifdef DEBUG
+    bool anidada_medida = (secciones_medidas() != antes);
+    #endif
+    drv_SC_salir_enable_irq(sc);
     
-    // Si no se cuelga, asumimos OK por ahora
+    #ifdef DEBUG
+    // Solo se mide la más exterior
+    if (anidada_medida || secciones_medidas() == antes) return false;
+
+    // drv_tiempo_esperar_ms duerme dentro de su sección: no se le cobra el sueño
+    uint32_t max_ciclos = dbg_sc_max_ciclos;
+    uint32_t max_us = dbg_sc_max_us;
+    dbg_sc_max_ciclos = 0;
+    dbg_sc_max_us = 0;
+    drv_tiempo_esperar_ms(10);
+    bool sueno_cobrado = (dbg_sc_max_us >= 5000u);
+    if (dbg_sc_max_ciclos < max_ciclos) {
+        dbg_sc_max_ciclos = max_ciclos;
+        dbg_sc_max_us = max_us;
+    }
+    if (sueno_cobrado) return false;
+    #endif
     return true; 
 }
 
+/* =============================================================================
+ * TEST: ALMACÉN PERSISTENTE EN FLASH
+ * ===========================================================================*/
+#define CLAVE_TEST_ALMACEN 0xFE
+
+bool test_almacen(void) {
+    uint32_t valor = 0, leido = 0;
+
+    // Un valor distinto en cada arranque: así siempre se escribe de verdad
+    svc_almacen_iniciar();
+    svc_almacen_leer(CLAVE_TEST_ALMACEN, &valor, sizeof(valor));
+    valor++;
+    if (!svc_almacen_guardar(CLAVE_TEST_ALMACEN, &valor, sizeof(valor))) return false;
+    if (!svc_almacen_pendiente()) return false;
+
+    svc_almacen_volcar_todo();
+    if (svc_almacen_pendiente()) return false;
+
+    // Releer desde la flash, como tras un apagado
+    svc_almacen_iniciar();
+    if (svc_almacen_leer(CLAVE_TEST_ALMACEN, &leido, sizeof(leido)) != sizeof(leido)) return false;
+    if (leido != valor) return false;
+
+    // No dejar la clave de prueba ocupando una de las SVC_ALMACEN_CLAVES de la aplicación
+    if (!svc_almacen_borrar(CLAVE_TEST_ALMACEN)) return false;
+    svc_almacen_volcar_todo();
+    svc_almacen_iniciar();
+    return svc_almacen_leer(CLAVE_TEST_ALMACEN, &leido, sizeof(leido)) == 0;
+}
+
 /* =============================================================================
  * TEST 5: BOTONES SIMULTÁNEOS (INTERACTIVO)
  * ===========================================================================*/
@@ -177,9 +332,14 @@ void test_botones_simultaneos(void) {
         uint32_t aux;
         
         // Procesamos eventos de botones manualmente desde la FIFO
+        // (la FSM del driver y sus alarmas también, para que lleguen pulsaciones confirmadas)
         if (rt_FIFO_extraer(&ev, &aux, NULL)) {
             if (ev == ev_PULSAR_BOTON || ev == ev_SOLTAR_BOTON) {
                 test_callback_botones(ev, aux);
+            } else if (ev == ev_BOTON_TIMER) {
+                drv_botones_actualizar(ev, aux);
+            } else if (ev == ev_T_PERIODICO) {
+                svc_alarma_actualizar(ev, aux);
             }
         }
     }
@@ -208,7 +368,13 @@ uint32_t test_ejecutar_todos(void) {
     if (test_alarmas()) pasados++;
     for(volatile int i=0; i<200000; i++);
     
+    if (test_conversion_tiempo()) pasados++;
+    
+    if (test_coma_fija()) pasados++;
+    
     if (test_seccion_critica()) pasados++;
     
+    if (test_almacen()) pasados++;
+    
     return pasados;
 }
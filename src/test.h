@@ -54,6 +54,49 @@ bool test_gestor_eventos(void);
  */
 bool test_alarmas(void);
 
+/**
+ * @brief Test de la conversión ticks -> us de drv_tiempo
+ * 
+ * Verifica:
+ * - Que la conversión por recíproco da lo mismo que la división
+ *   (bordes de división y valores de 64 bits)
+ * 
+ * En DEBUG además mide los ciclos por llamada de la división de 64 bits y de
+ * drv_tiempo_ticks_a_us (dbg_bench_ciclos_division / dbg_bench_ciclos_reciproco).
+ * 
+ * @return true si la conversión es exacta
+ */
+bool test_conversion_tiempo(void);
+
+/**
+ * @brief Test de la coma fija Q16.16 (svc_q16)
+ * 
+ * Verifica:
+ * - Producto y escalado Q16
+ * - Tempo sin deriva: 7 pulsos a 7 BPM suman 60 s
+ * - Escalado de tempo y conversión a BPM
+ * 
+ * En DEBUG además mide los ciclos por escalado con double y con Q16
+ * (dbg_bench_ciclos_double / dbg_bench_ciclos_q16).
+ * 
+ * @return true si todos los cálculos son correctos
+ */
+bool test_coma_fija(void);
+
+/**
+ * @brief Test del almacén persistente (svc_almacen)
+ * 
+ * Verifica:
+ * - Guardar deja el valor pendiente y se lee antes de volcarlo
+ * - Volcar lo escribe en flash
+ * - Tras volver a recorrer la flash (como al arrancar) se lee el mismo valor
+ * 
+ * Usa una clave propia (0xFE) y escribe un registro en cada ejecución.
+ * 
+ * @return true si el valor sobrevive al recorrido
+ */
+bool test_almacen(void);
+
 /**
  * @brief Iniciar test de botones con detección de pulsaciones simultáneas
  * 
@@ -120,7 +163,7 @@ bool test_watchdog(void);
  * - 101: Fin de suite
  * - 100+N: Suite finalizada con N tests pasados
  * 
- * @return Número de tests que pasaron (máximo 6)
+ * @return Número de tests que pasaron (máximo 7)
  */
 uint32_t test_ejecutar_todos(void);
 
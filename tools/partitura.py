@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""
+P.H.2025: Generador de partituras de Beat Hero (formato en src/svc_partitura.h).
+
+Uso:
+    python3 tools/partitura.py tools/partituras/*.txt -o src/partituras.c
+
+Cada .txt es una partitura, una orden por linea ('#' comenta):
+    nombre <texto>        nombre visible (por defecto, el del fichero)
+    tempo <ms>            duracion de paso en ms
+    seccion <nivel>       nivel de dificultad (0..15) a partir de aqui
+    aleatorio <n>         n pasos que genera el juego a su nivel
+    X.  [*n]              un paso: una columna por carril (2 como mucho),
+                          X = nota, . = nada;
+                          '*n' lo repite n veces
+    fin                   (opcional) termina la partitura
+
+Los pasos iguales seguidos se empaquetan (hasta 8 por byte).
+"""
+import argparse
+import os
+import sys
+
+FIN = 0x80
+TEMPO = 0x90
+SECCION = 0xA0
+ALEATORIO = 0xB0
+CARRILES_MAX = 2     # el formato admite 4, pero Beat Hero solo tiene dos botones
+REP_MAX = 8
+ALEATORIO_MAX = 16
+
+
+class ErrorPartitura(Exception):
+    pass
+
+
+def compilar(lineas, nombre_defecto):
+    nombre = nombre_defecto
+    salida = bytearray()
+    pasos = []          # pasos de nota pendientes de empaquetar
+
+    def volcar():
+        i = 0
+        while i < len(pasos):
+            c = pasos[i]
+            n = 1
+            while i + n < len(pasos) and pasos[i + n] == c and n < REP_MAX:
+                n += 1
+            salida.append(((n - 1) << 4) | c)
+            i += n
+        pasos.clear()
+
+    for num, linea in enumerate(lineas, 1):
+        linea = linea.split('#', 1)[0].strip()
+        if not linea:
+            continue
+        orden, _, resto = linea.partition(' ')
+        resto = resto.strip()
+        try:
+            if orden == 'nombre':
+                nombre = resto
+            elif orden == 'tempo':
+                ms = int(resto)
+                if not 1 <= ms <= 0xFFFF:
+                    raise ErrorPartitura('tempo fuera de rango')
+                volcar()
+                salida += bytes((TEMPO, ms & 0xFF, ms >> 8))
+            elif orden == 'seccion':
+                nivel = int(resto)
+                if not 0 <= nivel <= 15:
+                    raise ErrorPartitura('nivel fuera de rango')
+                volcar()
+                salida.append(SECCION | nivel)
+            elif orden == 'aleatorio':
+                n = int(resto)
+                if n < 1:
+                    raise ErrorPartitura('aleatorio necesita n >= 1')
+                volcar()
+                while n > 0:
+                    k = min(n, ALEATORIO_MAX)
+                    salida.append(ALEATORIO | (k - 1))
+                    n -= k
+            elif orden == 'fin':
+                break
+            else:
+                patron, _, rep = linea.partition('*')
+                patron = patron.strip()
+                if any(ch not in 'Xx.' for ch in patron):
+                    raise ErrorPartitura('paso no valido: %r' % patron)
+                if len(patron) > CARRILES_MAX:
+                    raise ErrorPartitura('paso con mas de %d carriles: %r' % (CARRILES_MAX, patron))
+                carriles = sum(1 << i for i, ch in enumerate(patron) if ch in 'Xx')
+                pasos.extend([carriles] * (int(rep) if rep else 1))
+        except (ValueError, ErrorPartitura) as e:
+            raise ErrorPartitura('linea %d: %s' % (num, e))
+    volcar()
+    salida.append(FIN)
+    return nombre, bytes(salida)
+
+
+def identificador(ruta):
+    base = os.path.splitext(os.path.basename(ruta))[0]
+    return 's_partitura_' + ''.join(ch if ch.isalnum() else '_' for ch in base)
+
+
+def generar_c(partituras):
+    out = ['/* *****************************************************************************',
+           ' * P.H.2025: Partituras de Beat Hero',
+           ' * GENERADO por tools/partitura.py: no editar, cambiar los .txt de tools/partituras',
+           ' */',
+           '#include "svc_partitura.h"',
+           '']
+    for ident, _, datos, origen in partituras:
+        out.append('/* %s (%d bytes) */' % (origen, len(datos)))
+        out.append('static const uint8_t %s[] = {' % ident)
+        for i in range(0, len(datos), 12):
+            out.append('    ' + ', '.join('0x%02X' % b for b in datos[i:i + 12]) + ',')
+        out.append('};')
+        out.append('')
+    out.append('const svc_partitura_t g_partituras[] = {')
+    for ident, nombre, _, _ in partituras:
+        out.append('    { "%s", %s, sizeof(%s) },' % (nombre.replace('"', '\\"'), ident, ident))
+    out.append('};')
+    out.append('')
+    out.append('const uint8_t g_num_partituras = sizeof(g_partituras) / sizeof(g_partituras[0]);')
+    out.append('')
+    return '\n'.join(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Compila partituras de Beat Hero a C')
+    ap.add_argument('fuentes', nargs='+', help='ficheros .txt (en el orden de g_partituras)')
+    ap.add_argument('-o', '--salida', default='-', help='fichero .c de salida')
+    args = ap.parse_args()
+
+    partituras = []
+    for ruta in args.fuentes:
+        with open(ruta, encoding='utf-8') as f:
+            try:
+                nombre, datos = compilar(f, os.path.splitext(os.path.basename(ruta))[0])
+            except ErrorPartitura as e:
+                sys.exit('%s: %s' % (ruta, e))
+        partituras.append((identificador(ruta), nombre, datos, os.path.basename(ruta)))
+
+    texto = generar_c(partituras)
+    if args.salida == '-':
+        sys.stdout.write(texto)
+    else:
+        with open(args.salida, 'w', encoding='utf-8', newline='\n') as f:
+            f.write(texto)
+
+
+if __name__ == '__main__':
+    main()